@@ -0,0 +1,128 @@
+#include "main.h"
+
+/*
+  Word-level evaluation of full adders.
+
+  Bit i of each word belongs to full adder i. The internal wires of the
+  full adders are
+
+    iw_1 = A ^ B, iw_2 = iw_1 & Cin, iw_3 = A & B,
+    S = iw_1 ^ Cin, Cout = iw_2 | iw_3.
+
+  For a ripple-carry chain the carry into each bit follows from the
+  integer sum: Cin = (A + B + Cin_0) ^ A ^ B.
+
+  The gates of a full adder are updated in topological order, so each of
+  its wires only changes once per update, from its old value to its new
+  one. Only the wires whose bit differs from the last committed value are
+  set, which counts their toggles exactly like the gates do.
+*/
+
+AdderKernel::AdderKernel(const vector<fa_t> &full_adders, bool _ripple)
+	: ripple(_ripple)
+	, num_bits(full_adders.size())
+	, num_words((full_adders.size() + 63) / 64)
+{
+	for (size_t i = 0; i < num_bits; ++i) {
+		const auto &fa = full_adders[i];
+		const auto &internal = fa->GetInternalWires();
+
+		A.wires.push_back(fa->GetWire(PORTS::A).get());
+		B.wires.push_back(fa->GetWire(PORTS::B).get());
+		S.wires.push_back(fa->GetWire(PORTS::O).get());
+		Cout.wires.push_back(fa->GetWire(PORTS::Cout).get());
+		iw_1.wires.push_back(internal[0].get());
+		iw_2.wires.push_back(internal[1].get());
+		iw_3.wires.push_back(internal[2].get());
+
+		// In a chain, only the first carry in comes from outside.
+		if (!ripple || i == 0) {
+			Cin.wires.push_back(fa->GetWire(PORTS::Cin).get());
+		}
+	}
+
+	for (auto *port : {&A, &B, &Cin, &S, &Cout, &iw_1, &iw_2, &iw_3}) {
+		Read(*port);
+	}
+
+	// When the outputs of some full adders are inputs of others, like in
+	// the last row of a carry-save multiplier, the gates see intermediate
+	// values that the words cannot reproduce.
+	unordered_set<const Wire *> outputs(S.wires.begin(), S.wires.end());
+	outputs.insert(Cout.wires.begin(), Cout.wires.end());
+	outputs.erase(nullptr);
+
+	for (const auto *port : {&A, &B, &Cin}) {
+		for (const auto &wire : port->wires) {
+			if (outputs.count(wire)) {
+				exact = false;
+			}
+		}
+	}
+}
+
+void AdderKernel::Evaluate() {
+	Read(A);
+	Read(B);
+	Read(Cin);
+
+	uint64_t carry = ripple ? (Cin.values[0] & 1) : 0;
+
+	for (size_t w = 0; w < num_words; ++w) {
+		const uint64_t a = A.values[w];
+		const uint64_t b = B.values[w];
+		uint64_t c;
+
+		if (ripple) {
+			uint64_t sum;
+			const bool overflow_ab = __builtin_add_overflow(a, b, &sum);
+			const bool overflow_c = __builtin_add_overflow(sum, carry, &sum);
+
+			c = sum ^ a ^ b;
+			carry = overflow_ab | overflow_c;
+		} else {
+			c = Cin.values[w];
+		}
+
+		const uint64_t x = a ^ b;
+
+		Commit(iw_1, w, x);
+		Commit(S, w, x ^ c);
+		Commit(iw_2, w, x & c);
+		Commit(iw_3, w, a & b);
+		Commit(Cout, w, (x & c) | (a & b));
+	}
+}
+
+// Reads the current values of the wires of a port. Unconnected wires read
+// as 0, like they do for the gates.
+void AdderKernel::Read(Port &port) const {
+	port.values.assign((port.wires.size() + 63) / 64, 0);
+
+	for (size_t i = 0; i < port.wires.size(); ++i) {
+		if (port.wires[i] && port.wires[i]->GetValue()) {
+			port.values[i / 64] |= 1ULL << (i % 64);
+		}
+	}
+}
+
+// Sets the wires of the bits that changed.
+void AdderKernel::Commit(Port &port, size_t word, uint64_t value) const {
+	if (word == num_words - 1 && num_bits % 64) {
+		value &= (1ULL << (num_bits % 64)) - 1;
+	}
+
+	uint64_t changed = value ^ port.values[word];
+	port.values[word] = value;
+
+	while (changed) {
+		const size_t bit = __builtin_ctzll(changed);
+		const auto &wire = port.wires[word * 64 + bit];
+
+		if (wire) {
+			wire->SetValue((value >> bit) & 1, false);
+		}
+
+		changed &= changed - 1;
+	}
+}
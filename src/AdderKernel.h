@@ -0,0 +1,32 @@
+#ifndef ADDERKERNEL_H
+#define ADDERKERNEL_H
+
+#include "main.h"
+
+// Evaluates a row of full adders with 64-bit words instead of gates.
+class AdderKernel {
+public:
+	AdderKernel(const vector<fa_t> &full_adders, bool _ripple);
+
+	void Evaluate();
+
+	const bool IsExact() const {return exact;}
+private:
+	// The wires of one port of every full adder, and the value of each bit
+	// that was last committed to them.
+	struct Port {
+		vector<Wire *> wires;
+		vector<uint64_t> values;
+	};
+
+	void Read(Port &port) const;
+	void Commit(Port &port, size_t word, uint64_t value) const;
+
+	bool ripple; // True if the carry out of each full adder is the carry in of the next.
+	size_t num_bits;
+	size_t num_words;
+	bool exact = true; // False if the row reads its own outputs.
+	Port A, B, Cin, S, Cout, iw_1, iw_2, iw_3;
+};
+
+#endif // ADDERKERNEL_H
@@ -0,0 +1,83 @@
+#include "main.h"
+
+// Finds every wire and component that can be reached from the wires of
+// the system, gives each of them a handle, and takes over the connections
+// of every wire. It can only be built once, since the wires no longer
+// know their connections afterwards.
+void Arena::Build(const wire_map_t &system_wires) {
+	unordered_map<const Wire *, uint32_t> wire_handles;
+	unordered_map<const Component *, uint32_t> component_handles;
+	vector<Wire *> wires_to_process;
+
+	auto add_wire = [&](Wire *wire) {
+		if (wire && wire_handles.emplace(wire, wires.size()).second) {
+			wires.push_back(wire);
+			wires_to_process.push_back(wire);
+		}
+	};
+
+	auto add_component = [&](Component *component) {
+		if (component && component_handles.emplace(component, components.size()).second) {
+			components.push_back(component);
+
+			for (const auto &w : component->GetWires()) {
+				add_wire(w.get());
+			}
+			for (const auto &w : component->GetInternalWires()) {
+				add_wire(w.get());
+			}
+		}
+	};
+
+	for (const auto &[name, wire] : system_wires) {
+		add_wire(wire.get());
+	}
+
+	while (!wires_to_process.empty()) {
+		const auto w = wires_to_process.back();
+		wires_to_process.pop_back();
+
+		add_component(w->GetComponentInput());
+		add_wire(w->GetWireInput());
+
+		for (const auto &c : w->GetComponentOutputs()) {
+			add_component(c);
+		}
+		for (const auto &o : w->GetWireOutputs()) {
+			add_wire(o);
+		}
+	}
+
+	const auto component_handle = [&](const Component *component) {
+		return component ? component_handles.at(component) : NONE;
+	};
+	const auto wire_handle = [&](const Wire *wire) {
+		return wire ? wire_handles.at(wire) : NONE;
+	};
+
+	// Every wire still needs its own connections until all of them are in
+	// the pools, so the spans are handed out afterwards.
+	vector<uint32_t> component_offsets;
+	vector<uint32_t> wire_offsets;
+
+	for (const auto &wire : wires) {
+		component_inputs.push_back(component_handle(wire->GetComponentInput()));
+		wire_inputs.push_back(wire_handle(wire->GetWireInput()));
+
+		component_offsets.push_back(component_fanout.size());
+		for (const auto &c : wire->GetComponentOutputs()) {
+			component_fanout.push_back(component_handle(c));
+		}
+
+		wire_offsets.push_back(wire_fanout.size());
+		for (const auto &o : wire->GetWireOutputs()) {
+			wire_fanout.push_back(wire_handle(o));
+		}
+	}
+	component_offsets.push_back(component_fanout.size());
+	wire_offsets.push_back(wire_fanout.size());
+
+	for (uint32_t w = 0; w < wires.size(); ++w) {
+		wires[w]->SetArena(this, w, component_offsets[w], component_offsets[w + 1], wire_offsets[w], wire_offsets[w + 1]);
+	}
+}
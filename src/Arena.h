@@ -0,0 +1,36 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "main.h"
+
+// Flat index of all wires and components of a System, addressed by 32-bit
+// handles. Once it is built, it holds the connections of every wire: the
+// driver of a wire is a handle, and its fanout is a span of handles in a
+// shared pool that the wire keeps the bounds of, so propagating a value
+// does not have to lock any weak_ptr. Only the connections are stored
+// contiguously. It does not allocate the wires and components themselves,
+// which are still owned by the System through shared_ptr.
+class Arena {
+public:
+	static constexpr uint32_t NONE = UINT32_MAX; // Handle of a driver that is not there.
+
+	void Build(const wire_map_t &system_wires);
+
+	const size_t GetNumWires() const {return wires.size();}
+	const size_t GetNumComponents() const {return components.size();}
+	Wire *GetWire(uint32_t handle) const {return handle == NONE ? nullptr : wires[handle];}
+	Component *GetComponent(uint32_t handle) const {return handle == NONE ? nullptr : components[handle];}
+	Component *GetComponentInput(uint32_t wire) const {return GetComponent(component_inputs[wire]);}
+	Wire *GetWireInput(uint32_t wire) const {return GetWire(wire_inputs[wire]);}
+	Wire *GetFanoutWire(uint32_t idx) const {return wires[wire_fanout[idx]];}
+	Component *GetFanoutComponent(uint32_t idx) const {return components[component_fanout[idx]];}
+private:
+	vector<Wire *> wires;
+	vector<Component *> components;
+	vector<uint32_t> component_inputs; // Handle of the component that drives each wire.
+	vector<uint32_t> wire_inputs;      // Handle of the wire that drives each wire.
+	vector<uint32_t> component_fanout; // Handles of the components driven by each wire.
+	vector<uint32_t> wire_fanout;      // Handles of the wires driven by each wire.
+};
+
+#endif // ARENA_H
@@ -0,0 +1,353 @@
+#include "main.h"
+
+/*
+  Word-level evaluation of array multipliers.
+
+  The subcomponents of a multiplier are split into rows in the order in
+  which they are updated: a row of AND gates that forms a partial product,
+  a row of adders that adds it, and so on. Bit i of each word belongs to
+  element i of the row. A new row starts when the type of the elements
+  changes, or when an element reads an output of the current row.
+
+  Components that are built from the same gates, like the encoders or the
+  decoders of a Booth multiplier, can be passed as a group. Their elements
+  are interleaved, so that the i-th gate of every component in the group
+  ends up in the same row.
+
+  The only exception is a carry chain, where an adder reads the carry out
+  of the previous adder in the row. With g = maj(A, B, Cin) and
+  p = A ^ B ^ Cin computed with the chained input at 0, the carry outs of
+  the row follow from
+
+    Cout[i] = g[i] | (p[i] & Cout[i - 1]),
+
+  which is solved for all bits at once with a prefix computation.
+
+  When every element only reads wires that are driven from outside or by
+  earlier elements, the gates settle in a single topological pass, and
+  each wire changes at most once per update. Only the wires whose bit
+  differs from the last committed value are set, which counts their
+  toggles exactly like the gates do. Otherwise, the kernel is not exact and
+  the multiplier keeps using its gates.
+*/
+
+static constexpr size_t NO_CHAIN = 3;
+
+// out = in << shift, over a vector of words.
+static void ShiftLeft(const vector<uint64_t> &in, size_t shift, vector<uint64_t> &out) {
+	const size_t words = shift / 64;
+	const size_t bits = shift % 64;
+
+	out.assign(in.size(), 0);
+
+	for (size_t w = words; w < in.size(); ++w) {
+		out[w] = in[w - words] << bits;
+
+		if (bits && w > words) {
+			out[w] |= in[w - words - 1] >> (64 - bits);
+		}
+	}
+}
+
+ArrayKernel::ArrayKernel(const vector<comp_t> &schedule) {
+	vector<Element> elements;
+
+	for (const auto &component : schedule) {
+		Flatten(component, elements);
+	}
+
+	BuildRows(elements);
+}
+
+ArrayKernel::ArrayKernel(const vector<vector<comp_t>> &groups) {
+	vector<Element> elements;
+
+	for (const auto &group : groups) {
+		vector<vector<Element>> lanes(group.size());
+		size_t num_elements = 0;
+
+		for (size_t i = 0; i < group.size(); ++i) {
+			Flatten(group[i], lanes[i]);
+			num_elements = max(num_elements, lanes[i].size());
+		}
+
+		for (size_t e = 0; e < num_elements; ++e) {
+			for (const auto &lane : lanes) {
+				if (e < lane.size()) {
+					elements.push_back(lane[e]);
+				}
+			}
+		}
+	}
+
+	BuildRows(elements);
+}
+
+void ArrayKernel::BuildRows(const vector<Element> &elements) {
+	if (!exact) {
+		return;
+	}
+
+	// The element that drives each wire.
+	unordered_map<const Wire *, size_t> drivers;
+
+	for (size_t e = 0; e < elements.size(); ++e) {
+		for (const auto &wire : elements[e].outputs) {
+			if (wire) {
+				drivers[wire] = e;
+			}
+		}
+	}
+
+	vector<size_t> row_of(elements.size());
+
+	for (size_t e = 0; e < elements.size(); ++e) {
+		const auto &element = elements[e];
+		bool new_row = rows.empty() || rows.back().type != element.type;
+		size_t chain_port = NO_CHAIN;
+
+		for (size_t k = 0; k < element.inputs.size(); ++k) {
+			const auto &wire = element.inputs[k];
+			const auto it = (wire ? drivers.find(wire) : drivers.end());
+
+			if (it == drivers.end()) {
+				continue;
+			}
+
+			if (it->second >= e) {
+				exact = false;
+				rows.clear();
+				return;
+			}
+
+			if (new_row || row_of[it->second] != rows.size() - 1) {
+				continue;
+			}
+
+			if (element.type == ROW_TYPE::ADDER &&
+				chain_port == NO_CHAIN &&
+				wire == rows.back().Cout.wires.back())
+			{
+				chain_port = k;
+			} else {
+				new_row = true;
+			}
+		}
+
+		if (new_row) {
+			rows.emplace_back();
+			rows.back().type = element.type;
+			chain_port = NO_CHAIN;
+		}
+
+		row_of[e] = rows.size() - 1;
+		AddElement(rows.back(), element, chain_port);
+	}
+
+	for (auto &row : rows) {
+		for (auto *port : {&row.A, &row.B, &row.Cin, &row.S, &row.Cout, &row.iw_1, &row.iw_2, &row.iw_3}) {
+			Read(*port);
+		}
+	}
+}
+
+void ArrayKernel::Evaluate() {
+	for (auto &row : rows) {
+		if (row.type == ROW_TYPE::ADDER) {
+			EvaluateAdders(row);
+		} else {
+			EvaluateGates(row);
+		}
+	}
+}
+
+// Collects the gates and adders of a component, expanding the composite
+// components that contain them.
+void ArrayKernel::Flatten(const comp_t &component, vector<Element> &elements) {
+	const auto wire = [&](PORTS port) {return component->GetWire(port).get();};
+
+	if (dynamic_pointer_cast<FullAdder>(component)) {
+		const auto &internal = component->GetInternalWires();
+
+		elements.push_back({ROW_TYPE::ADDER,
+							{wire(PORTS::A), wire(PORTS::B), wire(PORTS::Cin)},
+							{wire(PORTS::O), wire(PORTS::Cout), internal[0].get(), internal[1].get(), internal[2].get()}});
+	} else if (dynamic_pointer_cast<HalfAdder>(component)) {
+		elements.push_back({ROW_TYPE::ADDER,
+							{wire(PORTS::A), wire(PORTS::B), nullptr},
+							{wire(PORTS::O), wire(PORTS::Cout), nullptr, nullptr, nullptr}});
+	} else if (dynamic_pointer_cast<And>(component)) {
+		elements.push_back({ROW_TYPE::AND, {wire(PORTS::A), wire(PORTS::B), nullptr}, {wire(PORTS::O)}});
+	} else if (dynamic_pointer_cast<And3>(component)) {
+		elements.push_back({ROW_TYPE::AND3, {wire(PORTS::A), wire(PORTS::B), wire(PORTS::C)}, {wire(PORTS::O)}});
+	} else if (dynamic_pointer_cast<Nand>(component)) {
+		elements.push_back({ROW_TYPE::NAND, {wire(PORTS::A), wire(PORTS::B), nullptr}, {wire(PORTS::O)}});
+	} else if (dynamic_pointer_cast<Or>(component)) {
+		elements.push_back({ROW_TYPE::OR, {wire(PORTS::A), wire(PORTS::B), nullptr}, {wire(PORTS::O)}});
+	} else if (dynamic_pointer_cast<Or3>(component)) {
+		elements.push_back({ROW_TYPE::OR3, {wire(PORTS::A), wire(PORTS::B), wire(PORTS::C)}, {wire(PORTS::O)}});
+	} else if (dynamic_pointer_cast<Nor>(component)) {
+		elements.push_back({ROW_TYPE::NOR, {wire(PORTS::A), wire(PORTS::B), nullptr}, {wire(PORTS::O)}});
+	} else if (dynamic_pointer_cast<Nor3>(component)) {
+		elements.push_back({ROW_TYPE::NOR3, {wire(PORTS::A), wire(PORTS::B), wire(PORTS::C)}, {wire(PORTS::O)}});
+	} else if (dynamic_pointer_cast<Xor>(component)) {
+		elements.push_back({ROW_TYPE::XOR, {wire(PORTS::A), wire(PORTS::B), nullptr}, {wire(PORTS::O)}});
+	} else if (dynamic_pointer_cast<Xnor>(component)) {
+		elements.push_back({ROW_TYPE::XNOR, {wire(PORTS::A), wire(PORTS::B), nullptr}, {wire(PORTS::O)}});
+	} else if (dynamic_pointer_cast<Not>(component)) {
+		elements.push_back({ROW_TYPE::NOT, {wire(PORTS::I), nullptr, nullptr}, {wire(PORTS::O)}});
+	} else {
+		const auto subcomponents = component->GetSubcomponents();
+
+		if (subcomponents.empty()) {
+			exact = false;
+		}
+
+		for (const auto &subcomponent : subcomponents) {
+			Flatten(subcomponent, elements);
+		}
+	}
+}
+
+void ArrayKernel::AddElement(Row &row, const Element &element, size_t chain_port) {
+	const size_t bit = row.num_bits++;
+	const size_t num_words = (row.num_bits + 63) / 64;
+	Port *inputs[] = {&row.A, &row.B, &row.Cin};
+	vector<uint64_t> *chains[] = {&row.chain_A, &row.chain_B, &row.chain_Cin};
+	Port *outputs[] = {&row.S, &row.Cout, &row.iw_1, &row.iw_2, &row.iw_3};
+
+	for (size_t k = 0; k < element.inputs.size(); ++k) {
+		chains[k]->resize(num_words, 0);
+
+		// A chained input is not read from its wire, so it reads as 0.
+		if (k == chain_port) {
+			inputs[k]->wires.push_back(nullptr);
+			(*chains[k])[bit / 64] |= 1ULL << (bit % 64);
+			row.has_chain = true;
+		} else {
+			inputs[k]->wires.push_back(element.inputs[k]);
+		}
+	}
+
+	for (size_t k = 0; k < element.outputs.size(); ++k) {
+		outputs[k]->wires.push_back(element.outputs[k]);
+	}
+}
+
+void ArrayKernel::EvaluateGates(Row &row) {
+	Read(row.A);
+	Read(row.B);
+	Read(row.Cin);
+
+	for (size_t w = 0; w < row.S.values.size(); ++w) {
+		const uint64_t a = row.A.values[w];
+		const uint64_t b = row.B.values[w];
+		const uint64_t c = row.Cin.values[w];
+
+		switch (row.type) {
+		case ROW_TYPE::AND:  Commit(row, row.S, w, a & b);          break;
+		case ROW_TYPE::AND3: Commit(row, row.S, w, a & b & c);      break;
+		case ROW_TYPE::NAND: Commit(row, row.S, w, ~(a & b));       break;
+		case ROW_TYPE::OR:   Commit(row, row.S, w, a | b);          break;
+		case ROW_TYPE::OR3:  Commit(row, row.S, w, a | b | c);      break;
+		case ROW_TYPE::NOR:  Commit(row, row.S, w, ~(a | b));       break;
+		case ROW_TYPE::NOR3: Commit(row, row.S, w, ~(a | b | c));   break;
+		case ROW_TYPE::XOR:  Commit(row, row.S, w, a ^ b);          break;
+		case ROW_TYPE::XNOR: Commit(row, row.S, w, ~(a ^ b));       break;
+		case ROW_TYPE::NOT:  Commit(row, row.S, w, ~a);             break;
+		default: break;
+		}
+	}
+}
+
+void ArrayKernel::EvaluateAdders(Row &row) {
+	Read(row.A);
+	Read(row.B);
+	Read(row.Cin);
+
+	auto &A = row.A.values;
+	auto &B = row.B.values;
+	auto &Cin = row.Cin.values;
+	const size_t num_words = A.size();
+
+	if (row.has_chain) {
+		G.resize(num_words);
+		P.resize(num_words);
+
+		for (size_t w = 0; w < num_words; ++w) {
+			const uint64_t chained = row.chain_A[w] | row.chain_B[w] | row.chain_Cin[w];
+
+			G[w] = (A[w] & B[w]) | (A[w] & Cin[w]) | (B[w] & Cin[w]);
+			P[w] = (A[w] ^ B[w] ^ Cin[w]) & chained;
+		}
+
+		for (size_t shift = 1; shift < row.num_bits; shift <<= 1) {
+			ShiftLeft(G, shift, shifted);
+
+			for (size_t w = 0; w < num_words; ++w) {
+				G[w] |= P[w] & shifted[w];
+			}
+
+			ShiftLeft(P, shift, shifted);
+
+			for (size_t w = 0; w < num_words; ++w) {
+				P[w] &= shifted[w];
+			}
+		}
+
+		// G now holds the carry outs, so the chained inputs are known.
+		ShiftLeft(G, 1, shifted);
+
+		for (size_t w = 0; w < num_words; ++w) {
+			A[w] |= shifted[w] & row.chain_A[w];
+			B[w] |= shifted[w] & row.chain_B[w];
+			Cin[w] |= shifted[w] & row.chain_Cin[w];
+		}
+	}
+
+	for (size_t w = 0; w < num_words; ++w) {
+		const uint64_t a = A[w];
+		const uint64_t b = B[w];
+		const uint64_t c = Cin[w];
+		const uint64_t x = a ^ b;
+
+		Commit(row, row.iw_1, w, x);
+		Commit(row, row.S, w, x ^ c);
+		Commit(row, row.iw_2, w, x & c);
+		Commit(row, row.iw_3, w, a & b);
+		Commit(row, row.Cout, w, (x & c) | (a & b));
+	}
+}
+
+// Reads the current values of the wires of a port. Unconnected wires read
+// as 0, like they do for the gates.
+void ArrayKernel::Read(Port &port) const {
+	port.values.assign((port.wires.size() + 63) / 64, 0);
+
+	for (size_t i = 0; i < port.wires.size(); ++i) {
+		if (port.wires[i] && port.wires[i]->GetValue()) {
+			port.values[i / 64] |= 1ULL << (i % 64);
+		}
+	}
+}
+
+// Sets the wires of the bits that changed.
+void ArrayKernel::Commit(const Row &row, Port &port, size_t word, uint64_t value) const {
+	if (word == port.values.size() - 1 && row.num_bits % 64) {
+		value &= (1ULL << (row.num_bits % 64)) - 1;
+	}
+
+	uint64_t changed = value ^ port.values[word];
+	port.values[word] = value;
+
+	while (changed) {
+		const size_t bit = __builtin_ctzll(changed);
+		const auto &wire = port.wires[word * 64 + bit];
+
+		if (wire) {
+			wire->SetValue((value >> bit) & 1, false);
+		}
+
+		changed &= changed - 1;
+	}
+}
@@ -0,0 +1,60 @@
+#ifndef ARRAYKERNEL_H
+#define ARRAYKERNEL_H
+
+#include "main.h"
+
+// Evaluates the rows of gates and adders of an array multiplier with 64-bit
+// words instead of gates.
+class ArrayKernel {
+public:
+	ArrayKernel(const vector<comp_t> &schedule);
+	ArrayKernel(const vector<vector<comp_t>> &groups);
+
+	void Evaluate();
+
+	const bool IsExact() const {return exact;}
+	const size_t GetNumRows() const {return rows.size();}
+private:
+	enum class ROW_TYPE {AND, AND3, NAND, OR, OR3, NOR, NOR3, XOR, XNOR, NOT, ADDER};
+
+	// The wires of one port of every element of a row, and the value of
+	// each bit that was last committed to them.
+	struct Port {
+		vector<Wire *> wires;
+		vector<uint64_t> values;
+	};
+
+	struct Row {
+		ROW_TYPE type;
+		size_t num_bits = 0;
+		Port A, B, Cin, S, Cout, iw_1, iw_2, iw_3;
+
+		// The bits whose A, B or Cin is the carry out of the previous bit.
+		vector<uint64_t> chain_A, chain_B, chain_Cin;
+		bool has_chain = false;
+	};
+
+	// A gate, half adder or full adder with its inputs (A, B, Cin) and
+	// outputs (S, Cout, iw_1, iw_2, iw_3). Gates only use A, B, Cin as
+	// their inputs A, B, C, and S as their output.
+	struct Element {
+		ROW_TYPE type;
+		array<Wire *, 3> inputs;
+		array<Wire *, 5> outputs;
+	};
+
+	void BuildRows(const vector<Element> &elements);
+	void Flatten(const comp_t &component, vector<Element> &elements);
+	void AddElement(Row &row, const Element &element, size_t chain_port);
+	void EvaluateGates(Row &row);
+	void EvaluateAdders(Row &row);
+
+	void Read(Port &port) const;
+	void Commit(const Row &row, Port &port, size_t word, uint64_t value) const;
+
+	vector<Row> rows;
+	vector<uint64_t> G, P, shifted; // Scratch space for the carry chains.
+	bool exact = true; // False if the elements are not in topological order.
+};
+
+#endif // ARRAYKERNEL_H
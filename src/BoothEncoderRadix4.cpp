@@ -136,30 +136,7 @@ BoothEncoderRadix4::BoothEncoderRadix4(string _name)
 
 void BoothEncoderRadix4::Update(bool propagating) {
 	if (needs_update || !propagating) {
-		for (size_t i = 0; i < longest_path; ++i) {
-			X1_b->Update(propagating);
-			X2_b->Update(propagating);
-			Z->Update(propagating);
-			Row_LSB->Update(propagating);
-#ifdef METHOD_BEWICK
-			SE_nor3->Update(propagating);
-			SE_and3->Update(propagating);
-			SE_or->Update(propagating);
-			SE_and->Update(propagating);
-			SE_xnor->Update(propagating);
-			SE_xor->Update(propagating);
-#else
-			SE_nor3->Update(propagating);
-			SE_and3->Update(propagating);
-			SE_xnor->Update(propagating);
-			SE_or3->Update(propagating);
-#endif
-			Neg_cin_nor_1->Update(propagating);
-			Neg_cin_nor_2->Update(propagating);
-			Neg_cin_nor_3->Update(propagating);
-			Neg_cin_or3->Update(propagating);
-			Neg_cin_and->Update(propagating);
-		}
+		UpdateSubcomponents(propagating, longest_path);
 
 		if (!propagating && print_debug) {
 			PrintDebug();
@@ -169,6 +146,18 @@ void BoothEncoderRadix4::Update(bool propagating) {
 	}
 }
 
+const vector<comp_t> BoothEncoderRadix4::GetSubcomponents() const {
+#ifdef METHOD_BEWICK
+	return {X1_b, X2_b, Z, Row_LSB,
+			SE_nor3, SE_and3, SE_or, SE_and, SE_xnor, SE_xor,
+			Neg_cin_nor_1, Neg_cin_nor_2, Neg_cin_nor_3, Neg_cin_or3, Neg_cin_and};
+#else
+	return {X1_b, X2_b, Z, Row_LSB,
+			SE_nor3, SE_and3, SE_xnor, SE_or3,
+			Neg_cin_nor_1, Neg_cin_nor_2, Neg_cin_nor_3, Neg_cin_or3, Neg_cin_and};
+#endif
+}
+
 void BoothEncoderRadix4::Connect(PORTS port, const wire_t &wire, size_t index) {
 	auto error_undefined_port = [&](const auto &wire) {
 		Error("Trying to connect wire \"" + wire->GetName() + "\" to undefined port of BoothEncoderRadix4 \"" + name + "\".\n");
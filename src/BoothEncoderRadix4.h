@@ -11,6 +11,7 @@ public:
 	~BoothEncoderRadix4() = default;
 
 	void Update(bool propagating) override;
+	const vector<comp_t> GetSubcomponents() const override;
 	void Connect(PORTS port, const wire_t &wire, size_t index = 0) override;
 	void Connect(PORTS port, const wb_t &wires, size_t port_idx = 0, size_t wire_idx = 0) override;
 
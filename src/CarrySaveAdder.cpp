@@ -62,8 +62,14 @@ CarrySaveAdder::CarrySaveAdder(string _name,
 
 void CarrySaveAdder::Update(bool propagating) {
 	if (needs_update || !propagating) {
-		for (const auto &fa : full_adders) {
-			fa->Update(propagating);
+		if (word_level && !propagating && !word_kernel) {
+			word_kernel = make_unique<AdderKernel>(full_adders, false);
+		}
+
+		if (word_level && !propagating && word_kernel->IsExact()) {
+			UpdateBypassingSubcomponents([&]() {word_kernel->Evaluate();});
+		} else {
+			UpdateSubcomponents(propagating, 1);
 		}
 
 		needs_update = false;
@@ -74,6 +80,10 @@ void CarrySaveAdder::Update(bool propagating) {
 	}
 }
 
+const vector<comp_t> CarrySaveAdder::GetSubcomponents() const {
+	return vector<comp_t>(full_adders.begin(), full_adders.end());
+}
+
 void CarrySaveAdder::Connect(PORTS port, const wire_t &wire, size_t index) {
 	CheckIfIndexIsInRange(port, index);
 
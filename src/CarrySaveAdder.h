@@ -10,6 +10,7 @@ public:
 	~CarrySaveAdder() = default;
 
 	void Update(bool propagating) override;
+	const vector<comp_t> GetSubcomponents() const override;
 	void Connect(PORTS port, const wire_t &wire, size_t index = 0) override;
 	void Connect(PORTS port, const wb_t &wires, size_t port_idx = 0, size_t wire_idx = 0) override;
 
@@ -17,6 +18,7 @@ public:
 	const PORT_DIR GetPortDirection(PORTS port) const override;
 
 	void PrintDebug() const override;
+	void SetWordLevel(bool enable) override {word_level = enable;}
 
 	void GenerateVHDLEntity(const string &path) const override;
 	const string GenerateVHDLInstance() const override;
@@ -26,6 +28,8 @@ private:
 	size_t num_bits = 0;
 
 	vector<fa_t> full_adders;
+	bool word_level = false; // Evaluate the full adders with an AdderKernel instead of their gates.
+	unique_ptr<AdderKernel> word_kernel = nullptr;
 
 	// Used for generating HDL
 	static bool entityGenerated;
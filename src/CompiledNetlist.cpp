@@ -0,0 +1,203 @@
+#ifdef COMPILED_ENGINE
+#include <dlfcn.h>
+#endif
+#include <unistd.h>
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include "main.h"
+
+/*
+  Compiles a netlist to native code.
+
+  Every gate becomes one line of C++ in level order, which reads its
+  inputs from local variables and writes its output to a local variable,
+  so nothing is interpreted at runtime. The code is compiled with g++ into
+  a shared library, which is loaded with dlopen().
+
+  The libraries are kept in a cache directory and named after a hash of
+  the generated code, so the same netlist is only compiled once.
+
+  dlopen() does not work in the static binary that is built by default, so
+  the libraries are only loaded when built with COMPILED_ENGINE defined.
+*/
+
+static const string compiler = "g++ -O1 -shared -fPIC -nostdlib";
+
+#ifdef COMPILED_ENGINE
+// The contents of a file, or an empty string if it cannot be read.
+static const string ReadSource(const string &path) {
+	ifstream file(path);
+	stringstream contents;
+
+	contents << file.rdbuf();
+	return file ? contents.str() : "";
+}
+#endif
+
+CompiledNetlist::~CompiledNetlist() {
+#ifdef COMPILED_ENGINE
+	if (library) {
+		dlclose(library);
+	}
+#endif
+}
+
+void CompiledNetlist::Init(const Netlist &netlist) {
+#ifndef COMPILED_ENGINE
+	Error("The \"compiled\" engine is not available in this build. Build bitflipsim with \"make COMPILED_ENGINE=1\" to use it.\n");
+#else
+	const string source = Generate(netlist);
+
+	stringstream name;
+	name << hex << setw(16) << setfill('0') << Hash(source);
+
+	// A library is only loaded from the cache if its source is the same as
+	// the generated one, since another netlist can have the same hash. A
+	// library that anyone else could have written is compiled again.
+	const std::filesystem::path cache_path = GetCacheDirectory();
+	const string source_path = (cache_path / (name.str() + ".cpp")).string();
+	library_path = (cache_path / (name.str() + ".so")).string();
+	cached = IsPrivateFile(library_path) && IsPrivateFile(source_path) && ReadSource(source_path) == source;
+
+	// The temporary file that the library is loaded from if it cannot be
+	// kept in the cache.
+	string temp_library;
+
+	if (!cached) {
+		// Write and compile to temporary files first, so that other
+		// processes never read a file that is only partially written.
+		const string temp_source = (cache_path / (name.str() + '.' + to_string(getpid()) + ".cpp")).string();
+		temp_library = library_path + '.' + to_string(getpid());
+
+		ofstream source_file(temp_source);
+		source_file << source;
+		source_file.close();
+
+		if (!source_file) {
+			Error("Could not write the generated netlist to \"" + temp_source + "\".\n");
+		}
+
+		const string command = compiler + " -o \"" + temp_library + "\" \"" + temp_source + "\"";
+
+		if (system(command.c_str()) != 0) {
+			Error("Could not compile the generated netlist \"" + temp_source + "\".\n");
+		}
+
+		// The source of the library that is replaced is removed first, so
+		// that the new library is never taken for the one of that source.
+		std::error_code ec;
+		std::filesystem::permissions(temp_library, std::filesystem::perms::owner_all, ec);
+		if (!ec) {
+			std::filesystem::remove(source_path, ec);
+		}
+		if (!ec) {
+			std::filesystem::rename(temp_library, library_path, ec);
+		}
+		if (!ec) {
+			std::filesystem::rename(temp_source, source_path, ec);
+			temp_library.clear();
+		}
+		if (ec) {
+			std::filesystem::remove(temp_source, ec);
+		}
+	}
+
+	if (!temp_library.empty()) {
+		cout << "[Warning] The compiled netlist cannot be kept in the cache, so it is loaded from \"" << temp_library << "\".\n";
+		library_path = temp_library;
+	}
+
+	library = dlopen(library_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+	if (!library) {
+		Error("Could not load \"" + library_path + "\": " + dlerror() + '\n');
+	}
+
+	evaluate = (evaluate_t)dlsym(library, "bitflipsim_evaluate");
+	if (!evaluate) {
+		Error("Could not find the netlist function in \"" + library_path + "\".\n");
+	}
+
+	// A library that is loaded stays mapped once its file is removed.
+	if (!temp_library.empty()) {
+		std::error_code ec;
+		std::filesystem::remove(temp_library, ec);
+	}
+#endif
+}
+
+// Evaluates all gates for the values of the source nets in the state, and
+// updates the values of the other nets.
+void CompiledNetlist::Evaluate(NetState &state) const {
+	evaluate(state.values.data());
+}
+
+const string CompiledNetlist::Generate(const Netlist &netlist) const {
+	stringstream code;
+	const size_t num_gates = netlist.GetNumGates();
+	const size_t num_functions = (num_gates + GATES_PER_FUNCTION - 1) / GATES_PER_FUNCTION;
+
+	code << "// Generated by bitflipsim for a netlist of " << num_gates << " gates and "
+		 << netlist.GetNumNets() << " nets.\n"
+		 << "// v: value of each net.\n\n";
+
+	for (size_t f = 0; f < num_functions; ++f) {
+		const uint32_t begin = f * GATES_PER_FUNCTION;
+		const uint32_t end = min(num_gates, (f + 1) * GATES_PER_FUNCTION);
+
+		// Nets that are driven by a gate of this function are local
+		// variables, all others are read from v.
+		unordered_set<uint32_t> local_nets;
+		auto in = [&](uint32_t net) {
+			return local_nets.count(net) ? "n" + to_string(net) : "v[" + to_string(net) + "]";
+		};
+
+		code << "static void evaluate_" << f << "(unsigned char *v) {\n";
+
+		for (uint32_t gate = begin; gate < end; ++gate) {
+			const uint32_t out = netlist.GetGateOutput(gate);
+
+			// Nothing reads the outputs that are not connected.
+			if (out == Netlist::OPEN) {
+				continue;
+			}
+
+			const uint32_t *fanin = netlist.GetFanin(gate);
+			string a = in(fanin[0]);
+			string b = netlist.GetFaninSize(gate) > 1 ? in(fanin[1]) : "";
+			string c = netlist.GetFaninSize(gate) > 2 ? in(fanin[2]) : "";
+			string value;
+
+			switch (netlist.GetGateType(gate)) {
+			case Netlist::GATE::AND:  value = a + " & " + b; break;
+			case Netlist::GATE::AND3: value = a + " & " + b + " & " + c; break;
+			case Netlist::GATE::OR:   value = a + " | " + b; break;
+			case Netlist::GATE::OR3:  value = a + " | " + b + " | " + c; break;
+			case Netlist::GATE::XOR:  value = a + " ^ " + b; break;
+			case Netlist::GATE::NAND: value = "(" + a + " & " + b + ") ^ 1"; break;
+			case Netlist::GATE::NOR:  value = "(" + a + " | " + b + ") ^ 1"; break;
+			case Netlist::GATE::NOR3: value = "(" + a + " | " + b + " | " + c + ") ^ 1"; break;
+			case Netlist::GATE::XNOR: value = a + " ^ " + b + " ^ 1"; break;
+			case Netlist::GATE::NOT:  value = a + " ^ 1"; break;
+			case Netlist::GATE::MUX:  value = "(" + a + " & (" + c + " ^ 1)) | (" + b + " & " + c + ")"; break;
+			}
+
+			const string net = to_string(out);
+
+			code << "\tconst unsigned char n" << net << " = " << value << ";\n"
+				 << "\tv[" << net << "] = n" << net << ";\n";
+
+			local_nets.insert(out);
+		}
+
+		code << "}\n\n";
+	}
+
+	code << "extern \"C\" void bitflipsim_evaluate(unsigned char *v) {\n";
+	for (size_t f = 0; f < num_functions; ++f) {
+		code << "\tevaluate_" << f << "(v);\n";
+	}
+	code << "}\n";
+
+	return code.str();
+}
@@ -0,0 +1,29 @@
+#ifndef COMPILEDNETLIST_H
+#define COMPILEDNETLIST_H
+
+#include "main.h"
+
+class CompiledNetlist {
+public:
+	~CompiledNetlist();
+
+	void Init(const Netlist &netlist);
+	void Evaluate(NetState &state) const;
+
+	const string &GetLibraryPath() const {return library_path;}
+	const bool IsCached() const {return cached;}
+private:
+	using evaluate_t = void (*)(unsigned char *values);
+
+	// Gates per generated function, to keep the compile time in check.
+	static constexpr size_t GATES_PER_FUNCTION = 4096;
+
+	const string Generate(const Netlist &netlist) const;
+
+	void *library = nullptr;
+	evaluate_t evaluate = nullptr;
+	string library_path;
+	bool cached = false; // True if the library was already compiled by an earlier run.
+};
+
+#endif // COMPILEDNETLIST_H
@@ -21,6 +21,188 @@ const vector<wire_t> Component::GetWires() const {
 	return wires;
 }
 
+// Lets a transition table set the wires of the subcomponents instead of
+// updating them. The table replaces the word-level kernels as well, since
+// the subcomponents are no longer updated.
+void Component::SetTransitionTable(unique_ptr<TransitionTable> _table) {
+	table = move(_table);
+	SetWordLevel(false);
+}
+
+// Lets a response cache commit the wires of the subcomponents for transitions
+// that were already simulated. Like a table, it replaces the word-level
+// kernels, since they update the subcomponents without the cache.
+void Component::SetResponseCache(unique_ptr<ResponseCache> _cache) {
+	cache = move(_cache);
+	SetWordLevel(false);
+}
+
+// Updates the subcomponents num_passes times in the order of
+// GetSubcomponents(). Only the subcomponents with an input that changed
+// since their last update that was not propagating are updated, which gives
+// the same result because updating any other one does not change anything.
+// A subcomponent that is marked by one later in the order is updated in
+// the next pass, or in the next call after the last pass. Components with
+// a transition table use it instead, and components with a response cache
+// only update their subcomponents for input values that it does not have.
+void Component::UpdateSubcomponents(bool propagating, size_t num_passes) {
+	if (table) {
+		if (propagating) {
+			table->Evaluate(true);
+		} else {
+			UpdateBypassingSubcomponents([&]() {table->Evaluate(false);});
+		}
+
+		return;
+	}
+
+	if (cache) {
+		if (!cache->Lookup(propagating)) {
+			UpdateEachSubcomponent(propagating, num_passes);
+			cache->Store(propagating);
+		} else if (propagating) {
+			cache->Apply(true);
+		} else {
+			UpdateBypassingSubcomponents([&]() {cache->Apply(false);});
+		}
+
+		return;
+	}
+
+	UpdateEachSubcomponent(propagating, num_passes);
+}
+
+void Component::UpdateEachSubcomponent(bool propagating, size_t num_passes) {
+	InitWorklist();
+
+	if (!worklist) {
+		return;
+	}
+
+	auto &subcomponents = worklist->subcomponents;
+	auto &ready = worklist->ready;
+	auto &next = worklist->next;
+
+	if (propagating) {
+		// Only the subcomponents with an input that changed since their last
+		// commit can change anything, and those are the ones in the
+		// worklist. They stay in it, since the outputs that they set while
+		// propagating are not committed yet.
+		vector<size_t> updated;
+
+		for (size_t i = 0; i < num_passes && !ready.empty(); ++i) {
+			worklist->updating = true;
+
+			while (!ready.empty()) {
+				pop_heap(ready.begin(), ready.end(), greater<size_t>());
+				worklist->position = ready.back();
+				ready.pop_back();
+
+				updated.push_back(worklist->position);
+				subcomponents[worklist->position]->Update(true);
+			}
+
+			worklist->updating = false;
+			swap(ready, next);
+
+			for (const auto &idx : updated) {
+				ready.push_back(idx);
+				push_heap(ready.begin(), ready.end(), greater<size_t>());
+			}
+			updated.clear();
+		}
+
+		return;
+	}
+
+	dirty = false;
+
+	for (size_t i = 0; i < num_passes && !ready.empty(); ++i) {
+		worklist->updating = true;
+
+		while (!ready.empty()) {
+			pop_heap(ready.begin(), ready.end(), greater<size_t>());
+			worklist->position = ready.back();
+			ready.pop_back();
+
+			const auto &c = subcomponents[worklist->position];
+			c->dirty = false;
+			c->Update(false);
+		}
+
+		worklist->updating = false;
+		swap(ready, next);
+	}
+}
+
+// Runs update, which sets the wires inside the subcomponents directly
+// instead of updating them, and marks the subcomponents as up to date.
+void Component::UpdateBypassingSubcomponents(const function<void()> &update) {
+	InitWorklist();
+
+	// Wires that update sets only mark subcomponents of this component, so
+	// this component does not have to be updated again.
+	dirty = true;
+	update();
+	if (worklist) {
+		ClearWorklist();
+	}
+	dirty = false;
+}
+
+// Creates the worklists of this component and all of its subcomponents,
+// so that a subcomponent that is marked also marks its parent.
+void Component::InitWorklist() {
+	if (worklist) {
+		return;
+	}
+
+	const auto subcomponents = GetSubcomponents();
+	if (subcomponents.empty()) {
+		return;
+	}
+
+	// The next pass can have all subcomponents, so its heap never has to
+	// grow while they are updated.
+	worklist = make_unique<Worklist>();
+	worklist->next.reserve(subcomponents.size());
+
+	for (const auto &c : subcomponents) {
+		c->parent = this;
+		c->index_in_parent = worklist->subcomponents.size();
+		c->dirty = true;
+		c->InitWorklist();
+		worklist->ready.push_back(worklist->subcomponents.size());
+		worklist->subcomponents.push_back(c.get());
+	}
+}
+
+// Marks the subcomponents that are waiting for an update as up to date.
+void Component::ClearWorklist() {
+	for (auto *queue : {&worklist->ready, &worklist->next}) {
+		for (const auto &idx : *queue) {
+			const auto &c = worklist->subcomponents[idx];
+
+			c->dirty = false;
+			c->Reset();
+			if (c->worklist) {
+				c->ClearWorklist();
+			}
+		}
+
+		queue->clear();
+	}
+}
+
+void Component::EnqueueSubcomponent(size_t idx) {
+	auto &queue = (worklist->updating && idx <= worklist->position) ? worklist->next : worklist->ready;
+
+	queue.push_back(idx);
+	push_heap(queue.begin(), queue.end(), greater<size_t>());
+
+	MarkDirty();
+}
+
 void Component::GenerateAssignments(const PORTS port,
 									const size_t port_width,
 									const string &signal_name,
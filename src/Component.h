@@ -16,13 +16,26 @@ public:
 	virtual void Connect(PORTS port, const wire_t &wire, size_t index = 0) =0;
 	virtual void Connect(PORTS port, const wb_t &wires, size_t port_idx = 0, size_t wire_idx = 0) =0;
 	virtual void Connect(PORTS port, const wb_t &wires, size_t port_begin_idx, size_t port_end_idx, size_t wire_begin_idx) {};
-	void MarkUpdate() {needs_update = true;}
+	void MarkUpdate() {needs_update = true; MarkDirty();}
+	void MarkDirty() {
+		if (!dirty) {
+			dirty = true;
+
+			if (parent) {
+				parent->EnqueueSubcomponent(index_in_parent);
+			}
+		}
+	}
 	void Reset() {needs_update = false;}
+	void InitWorklist();
+	void SetLevel(size_t _level) {level = _level;}
 
 	const string &GetName() const {return name;}
 	const size_t GetLongestPath() const {return longest_path;}
+	const size_t GetLevel() const {return level;}
 	const virtual vector<wire_t> GetWires() const;
 	const virtual vector<wire_t> GetInputWires() const {return input_wires;}
+	const virtual vector<comp_t> GetSubcomponents() const {return {};}
 	const vector<wire_t> &GetInternalWires() const {return internal_wires;}
 	const vector<wire_t> &GetOutputWires() const {return output_wires;}
 	const virtual wire_t GetWire(PORTS port, size_t index = 0) const =0;
@@ -30,6 +43,10 @@ public:
 
 	void PrintDebugAfterUpdate(bool value) {print_debug = value;}
 	virtual void PrintDebug() const {};
+	virtual void SetWordLevel(bool enable) {};
+	void SetTransitionTable(unique_ptr<TransitionTable> _table);
+	void SetResponseCache(unique_ptr<ResponseCache> _cache);
+	const bool HasTransitionTable() const {return table != nullptr;}
 
 	virtual void GenerateVHDLEntity(const string &path) const {};
 	const virtual string GenerateVHDLInstance() const =0;
@@ -39,6 +56,8 @@ protected:
 	}
 
 	virtual void CheckIfIndexIsInRange(PORTS port, size_t index) const {return;}
+	void UpdateSubcomponents(bool propagating, size_t num_passes);
+	void UpdateBypassingSubcomponents(const function<void()> &update);
 	void GenerateAssignments(const PORTS port,
 							 const size_t port_width,
 							 const string &signal_name,
@@ -48,12 +67,34 @@ protected:
 	string name;
 	bool needs_update = false;
 	size_t longest_path = 1; // Default path length is 1.
+	size_t level = 0; // Topological level of a primitive gate, set by System::Levelize().
 
 	bool print_debug = false;
 
 	vector<wire_t> input_wires;
 	vector<wire_t> internal_wires;
 	vector<wire_t> output_wires;
+private:
+	// Subcomponents of a composite component whose inputs changed since they
+	// were last updated, as indices into subcomponents.
+	struct Worklist {
+		vector<Component *> subcomponents; // In the order they are updated.
+		vector<size_t> ready; // Min-heap of the ones to update in this pass.
+		vector<size_t> next; // Min-heap of the ones to update in the next pass.
+		bool updating = false;
+		size_t position = 0; // The subcomponent that is being updated.
+	};
+
+	void UpdateEachSubcomponent(bool propagating, size_t num_passes);
+	void ClearWorklist();
+	void EnqueueSubcomponent(size_t idx);
+
+	Component *parent = nullptr; // The composite component that updates this one.
+	size_t index_in_parent = 0;
+	bool dirty = true; // True if an input changed since the last update that was not propagating.
+	unique_ptr<Worklist> worklist = nullptr;
+	unique_ptr<TransitionTable> table = nullptr; // Evaluates the subcomponents with a lookup when set.
+	unique_ptr<ResponseCache> cache = nullptr; // Commits the transitions of the subcomponents that were already simulated when set.
 };
 
 #endif // COMPONENT_H
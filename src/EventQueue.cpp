@@ -0,0 +1,75 @@
+#include "main.h"
+
+/*
+  Zero-delay event queue with one bucket per topological level.
+
+  A gate is scheduled when one of the nets it reads changes value. Gates
+  only drive gates on higher levels, so processing the buckets from the
+  lowest to the highest level evaluates every scheduled gate exactly once,
+  after all of its inputs have settled.
+*/
+
+// The event count is kept, so that the queue can move to another netlist
+// over the same nets between updates.
+void EventQueue::Init(const Netlist &_netlist) {
+	netlist = &_netlist;
+	buckets.clear();
+	buckets.resize(netlist->GetNumLevels());
+	scheduled.assign(netlist->GetNumGates(), false);
+}
+
+// Schedules all gates that read the given net.
+void EventQueue::ScheduleFanout(uint32_t net) {
+	const uint32_t *fanout = netlist->GetFanout(net);
+	const size_t fanout_size = netlist->GetFanoutSize(net);
+
+	for (size_t i = 0; i < fanout_size; ++i) {
+		const uint32_t gate = fanout[i];
+
+		if (!scheduled[gate]) {
+			scheduled[gate] = true;
+			buckets[netlist->GetGateLevel(gate)].push_back(gate);
+		}
+	}
+}
+
+// Drops all scheduled gates without evaluating them.
+void EventQueue::Clear() {
+	for (auto &bucket : buckets) {
+		for (const auto &gate : bucket) {
+			scheduled[gate] = false;
+		}
+		bucket.clear();
+	}
+}
+
+// Evaluates all scheduled gates in level order, and returns how many
+// gates were evaluated.
+const size_t EventQueue::Process(NetState &state) {
+	size_t events = 0;
+
+	for (auto &bucket : buckets) {
+		// Evaluating a gate only schedules gates on higher levels,
+		// so this bucket does not grow while we process it.
+		for (const auto &gate : bucket) {
+			scheduled[gate] = false;
+
+			const uint32_t out = netlist->GetGateOutput(gate);
+			uint8_t value;
+			netlist->Evaluate(gate, state.values.data(), value);
+
+			if (state.values[out] != value) {
+				state.values[out] = value;
+				state.toggles[out]++;
+				state.num_toggles += netlist->GetToggleWeight(out);
+				ScheduleFanout(out);
+			}
+		}
+
+		events += bucket.size();
+		bucket.clear();
+	}
+
+	num_events += events;
+	return events;
+}
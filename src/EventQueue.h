@@ -0,0 +1,21 @@
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include "main.h"
+
+class EventQueue {
+public:
+	void Init(const Netlist &_netlist);
+	void ScheduleFanout(uint32_t net);
+	void Clear();
+	const size_t Process(NetState &state);
+
+	const size_t GetNumEvents() const {return num_events;}
+private:
+	const Netlist *netlist = nullptr;
+	vector<vector<uint32_t>> buckets; // Scheduled gates, one bucket per level.
+	vector<uint8_t> scheduled; // True for gates that are in one of the buckets.
+	size_t num_events = 0; // Total number of gate evaluations.
+};
+
+#endif // EVENTQUEUE_H
@@ -50,18 +50,16 @@ FullAdder::FullAdder(string _name)
 
 void FullAdder::Update(bool propagating) {
 	if (needs_update || !propagating) {
-		for (size_t i = 0; i < longest_path; ++i) {
-			xor_ab->Update(propagating);
-			xor_cin->Update(propagating);
-			and_cin->Update(propagating);
-			and_ab->Update(propagating);
-			or_cout->Update(propagating);
-		}
+		UpdateSubcomponents(propagating, longest_path);
 
 		needs_update = false;
 	}
 }
 
+const vector<comp_t> FullAdder::GetSubcomponents() const {
+	return {xor_ab, xor_cin, and_cin, and_ab, or_cout};
+}
+
 void FullAdder::Connect(PORTS port, const wire_t &wire, size_t index) {
 	switch (port) {
 	case PORTS::A:
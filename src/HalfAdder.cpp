@@ -25,13 +25,16 @@ HalfAdder::HalfAdder(string _name)
 
 void HalfAdder::Update(bool propagating) {
 	if (needs_update || !propagating) {
-		xor_ha->Update(propagating);
-		and_ha->Update(propagating);
+		UpdateSubcomponents(propagating, 1);
 
 		needs_update = false;
 	}
 }
 
+const vector<comp_t> HalfAdder::GetSubcomponents() const {
+	return {xor_ha, and_ha};
+}
+
 void HalfAdder::Connect(PORTS port, const wire_t &wire, size_t index) {
 	switch (port) {
 	case PORTS::A:
@@ -43,88 +43,60 @@ Multiplier_2C::Multiplier_2C(string _name,
 
 void Multiplier_2C::Update(bool propagating) {
 	if (needs_update || !propagating) {
-		switch (type) {
-		case MUL_TYPE::CARRY_PROPAGATE_SIGN_EXTEND:
-		case MUL_TYPE::CARRY_SAVE_SIGN_EXTEND:
-			for (size_t i = 0; i < longest_path; ++i) {
-				for (const auto &and_row : ands) {
-					for (const auto &a : and_row) {
-						a->Update(propagating);
-					}
-				}
-				for (const auto &adder_row : adders) {
-					for (const auto &a : adder_row) {
-						a->Update(propagating);
-					}
-				}
-			}
-			break;
-		case MUL_TYPE::CARRY_SAVE_BAUGH_WOOLEY:
-			for (size_t i = 0; i < longest_path; ++i) {
-				for (const auto &notA : input_nots_A) {
-					notA->Update(propagating);
-				}
-				for (const auto &notB : input_nots_B) {
-					notB->Update(propagating);
-				}
-				for (const auto &and_row : ands) {
-					for (const auto &a : and_row) {
-						a->Update(propagating);
-					}
-				}
-				for (const auto &adder_row : adders) {
-					for (const auto &a : adder_row) {
-						a->Update(propagating);
-					}
-				}
-			}
-			break;
-		case MUL_TYPE::CARRY_PROPAGATE_INVERSION:
-		case MUL_TYPE::CARRY_SAVE_INVERSION:
-			for (size_t i = 0; i < longest_path; ++i) {
-				different_sign->Update(propagating);
-				
-				for (const auto &xor_A : input_2C_xors_A) {
-					xor_A->Update(propagating);
-				}
-				for (const auto &xor_B : input_2C_xors_B) {
-					xor_B->Update(propagating);
-				}
-				for (const auto &add_A : input_2C_adders_A) {
-					add_A->Update(propagating);
-				}
-				for (const auto &add_B : input_2C_adders_B) {
-					add_B->Update(propagating);
-				}
-				for (const auto &and_row : ands) {
-					for (const auto &a : and_row) {
-						a->Update(propagating);
-					}
-				}
-				for (const auto &adder_row : adders) {
-					for (const auto &a : adder_row) {
-						a->Update(propagating);
-					}
-				}
-				for (const auto &xor_o : output_2C_xors) {
-					xor_o->Update(propagating);
-				}
-				for (const auto &add_o : output_2C_adders) {
-					add_o->Update(propagating);
-				}
+		if (word_level && !propagating && !word_kernel) {
+			word_kernel = make_unique<ArrayKernel>(GetSubcomponents());
+		}
 
-				output_2C_adder_xor->Update(propagating);
-			}
-			break;
-		default:
-			Error("Multiplier not implemented yet!\n");
-			break;
+		if (word_level && !propagating && word_kernel->IsExact()) {
+			UpdateBypassingSubcomponents([&]() {word_kernel->Evaluate();});
+		} else {
+			UpdateSubcomponents(propagating, longest_path);
 		}
 
 		needs_update = false;
 	}
 }
 
+const vector<comp_t> Multiplier_2C::GetSubcomponents() const {
+	vector<comp_t> subcomponents;
+
+	switch (type) {
+	case MUL_TYPE::CARRY_PROPAGATE_SIGN_EXTEND:
+	case MUL_TYPE::CARRY_SAVE_SIGN_EXTEND:
+		break;
+	case MUL_TYPE::CARRY_SAVE_BAUGH_WOOLEY:
+		subcomponents.insert(subcomponents.end(), input_nots_A.begin(), input_nots_A.end());
+		subcomponents.insert(subcomponents.end(), input_nots_B.begin(), input_nots_B.end());
+		break;
+	case MUL_TYPE::CARRY_PROPAGATE_INVERSION:
+	case MUL_TYPE::CARRY_SAVE_INVERSION:
+		subcomponents.push_back(different_sign);
+		subcomponents.insert(subcomponents.end(), input_2C_xors_A.begin(), input_2C_xors_A.end());
+		subcomponents.insert(subcomponents.end(), input_2C_xors_B.begin(), input_2C_xors_B.end());
+		subcomponents.insert(subcomponents.end(), input_2C_adders_A.begin(), input_2C_adders_A.end());
+		subcomponents.insert(subcomponents.end(), input_2C_adders_B.begin(), input_2C_adders_B.end());
+		break;
+	default:
+		Error("Multiplier not implemented yet!\n");
+		break;
+	}
+
+	for (const auto &and_row : ands) {
+		subcomponents.insert(subcomponents.end(), and_row.begin(), and_row.end());
+	}
+	for (const auto &adder_row : adders) {
+		subcomponents.insert(subcomponents.end(), adder_row.begin(), adder_row.end());
+	}
+
+	if (type == MUL_TYPE::CARRY_PROPAGATE_INVERSION || type == MUL_TYPE::CARRY_SAVE_INVERSION) {
+		subcomponents.insert(subcomponents.end(), output_2C_xors.begin(), output_2C_xors.end());
+		subcomponents.insert(subcomponents.end(), output_2C_adders.begin(), output_2C_adders.end());
+		subcomponents.push_back(output_2C_adder_xor);
+	}
+
+	return subcomponents;
+}
+
 void Multiplier_2C::Connect(PORTS port, const wire_t &wire, size_t index) {
 	if (port == PORTS::A && index >= num_bits_A) {
 		Error("Index " + to_string(index) + " of port A is out of bounds for Multiplier_2C \"" + name + "\".\n");
@@ -14,12 +14,15 @@ public:
 	~Multiplier_2C() = default;
 
 	void Update(bool propagating) override;
+	const vector<comp_t> GetSubcomponents() const override;
 	void Connect(PORTS port, const wire_t &wire, size_t index) override;
 	void Connect(PORTS port, const wb_t &wires, size_t port_idx = 0, size_t wire_idx = 0) override;
 
 	const wire_t GetWire(PORTS port, size_t index) const override;
 	const PORT_DIR GetPortDirection(PORTS port) const override;
 
+	void SetWordLevel(bool enable) override {word_level = enable;}
+
 	void GenerateVHDLEntity(const string &path) const override;
 	const string GenerateVHDLInstance() const override;
 
@@ -51,6 +54,9 @@ private:
 	xor_t output_2C_adder_xor = nullptr;
 	xor_t different_sign = nullptr;
 
+	bool word_level = false; // Evaluate the rows of the array with an ArrayKernel instead of their gates.
+	unique_ptr<ArrayKernel> word_kernel = nullptr;
+
 	MUL_TYPE type = MUL_TYPE::CARRY_SAVE_SIGN_EXTEND;
 };
 
@@ -33,24 +33,46 @@ Multiplier_2C_Booth::Multiplier_2C_Booth(string _name,
 
 void Multiplier_2C_Booth::Update(bool propagating) {
 	if (needs_update || !propagating) {
-		for (size_t i = 0; i < longest_path; ++i) {
-			for (const auto &e : encoders) {
-				e->Update(propagating);
-			}
-			se_not->Update(propagating);
-			for (const auto &d : decoders) {
-				d->Update(propagating);
-			}
-			for (const auto &c : cs_adders) {
-				c->Update(propagating);
-			}
-			final_adder->Update(propagating);
+		if (word_level && !propagating && !word_kernel) {
+			// The encoders and the decoders are each built from the same
+			// gates, so every row of the kernel covers all of them.
+			word_kernel = make_unique<ArrayKernel>(vector<vector<comp_t>>{
+					{encoders.begin(), encoders.end()},
+					{se_not},
+					{decoders.begin(), decoders.end()}});
+		}
+
+		if (word_level && !propagating && word_kernel->IsExact()) {
+			UpdateBypassingSubcomponents([&]() {
+				word_kernel->Evaluate();
+
+				// Each carry-save adder only reads the decoders and the
+				// adders before it, so a single pass settles them.
+				for (const auto &csa : cs_adders) {
+					csa->Update(false);
+				}
+
+				final_adder->Update(false);
+			});
+		} else {
+			UpdateSubcomponents(propagating, longest_path);
 		}
 
 		needs_update = false;
 	}
 }
 
+const vector<comp_t> Multiplier_2C_Booth::GetSubcomponents() const {
+	vector<comp_t> subcomponents(encoders.begin(), encoders.end());
+
+	subcomponents.push_back(se_not);
+	subcomponents.insert(subcomponents.end(), decoders.begin(), decoders.end());
+	subcomponents.insert(subcomponents.end(), cs_adders.begin(), cs_adders.end());
+	subcomponents.push_back(final_adder);
+
+	return subcomponents;
+}
+
 void Multiplier_2C_Booth::Connect(PORTS port, const wire_t &wire, size_t index) {
 	CheckIfIndexIsInRange(port, index);
 
@@ -11,12 +11,15 @@ public:
 	~Multiplier_2C_Booth() = default;
 
 	void Update(bool propagating) override;
+	const vector<comp_t> GetSubcomponents() const override;
 	void Connect(PORTS port, const wire_t &wire, size_t index) override;
 	void Connect(PORTS port, const wb_t &wires, size_t port_idx = 0, size_t wire_idx = 0) override;
 
 	const wire_t GetWire(PORTS port, size_t index = 0) const override;
 	const PORT_DIR GetPortDirection(PORTS port) const override;
 
+	void SetWordLevel(bool enable) override {word_level = enable;}
+
 	void GenerateVHDLEntity(const string &path) const override;
 	const string GenerateVHDLInstance() const override;
 
@@ -48,6 +51,9 @@ private:
 	and_t se_and;
 	xor_t se_xor;
 
+	bool word_level = false; // Evaluate the encoders and decoders with an ArrayKernel instead of their gates.
+	unique_ptr<ArrayKernel> word_kernel = nullptr;
+
 	static bool entityGenerated; // Used for generating HDL
 };
 
@@ -37,41 +37,42 @@ Multiplier_Smag::Multiplier_Smag(string _name,
 
 void Multiplier_Smag::Update(bool propagating) {
 	if (needs_update || !propagating) {
-		switch (type) {
-		case MUL_TYPE::CARRY_PROPAGATE:
-			for (size_t i = 0; i < longest_path; ++i) {
-				for (const auto &and_row : ands) {
-					for (const auto &a : and_row) {
-						a->Update(propagating);
-					}
-				}
-				for (const auto &adder_row : rc_adders) {
-					adder_row->Update(propagating);
-				}
-			}
-
-			sign->Update(propagating);
-			break;
-		case MUL_TYPE::CARRY_SAVE:
-			for (size_t i = 0; i < longest_path; ++i) {
-				for (const auto &and_row : ands) {
-					for (const auto &a : and_row) {
-						a->Update(propagating);
-					}
-				}
-				for (const auto &adder_row : cs_adders) {
-					adder_row->Update(propagating);
-				}
-			}
+		if (word_level && !propagating && !word_kernel) {
+			word_kernel = make_unique<ArrayKernel>(GetSubcomponents());
+		}
 
-			sign->Update(propagating);
-			break;
+		if (word_level && !propagating && word_kernel->IsExact()) {
+			UpdateBypassingSubcomponents([&]() {word_kernel->Evaluate();});
+		} else {
+			UpdateSubcomponents(propagating, longest_path);
 		}
 
 		needs_update = false;
 	}
 }
 
+const vector<comp_t> Multiplier_Smag::GetSubcomponents() const {
+	vector<comp_t> subcomponents;
+
+	for (const auto &and_row : ands) {
+		subcomponents.insert(subcomponents.end(), and_row.begin(), and_row.end());
+	}
+
+	switch (type) {
+	case MUL_TYPE::CARRY_PROPAGATE:
+		subcomponents.insert(subcomponents.end(), rc_adders.begin(), rc_adders.end());
+		break;
+	case MUL_TYPE::CARRY_SAVE:
+		subcomponents.insert(subcomponents.end(), cs_adders.begin(), cs_adders.end());
+		break;
+	}
+
+	// The sign only depends on the inputs, so it settles in the first pass.
+	subcomponents.push_back(sign);
+
+	return subcomponents;
+}
+
 void Multiplier_Smag::Connect(PORTS port, const wire_t &wire, size_t index) {
 	CheckIfIndexIsInRange(port, index);
 
@@ -14,12 +14,15 @@ public:
 	~Multiplier_Smag() = default;
 
 	void Update(bool propagating) override;
+	const vector<comp_t> GetSubcomponents() const override;
 	void Connect(PORTS port, const wire_t &wire, size_t index) override;
 	void Connect(PORTS port, const wb_t &wires, size_t port_idx = 0, size_t wire_idx = 0) override;
 
 	const wire_t GetWire(PORTS port, size_t index = 0) const override;
 	const PORT_DIR GetPortDirection(PORTS port) const override;
 
+	void SetWordLevel(bool enable) override {word_level = enable;}
+
 	void GenerateVHDLEntity(const string &path) const override;
 	const string GenerateVHDLInstance() const override;
 
@@ -42,6 +45,9 @@ private:
 	vector<vector<and_t>> ands;
 	xor_t sign = nullptr;
 
+	bool word_level = false; // Evaluate the rows of the array with an ArrayKernel instead of their gates.
+	unique_ptr<ArrayKernel> word_kernel = nullptr;
+
 	MUL_TYPE type = MUL_TYPE::CARRY_PROPAGATE;
 
 	static bool entityGenerated; // Used for HDL generation.
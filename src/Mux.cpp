@@ -19,7 +19,7 @@ void Mux::Update(bool propagating) {
 
 		inA = A ? A->GetValue() : false;
 		inB = B ? B->GetValue() : false;
-		inS = S ? B->GetValue() : false;
+		inS = S ? S->GetValue() : false;
 
 		if (O) {
 			O->SetValue(inS ? inB : inA, propagating);
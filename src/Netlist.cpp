@@ -0,0 +1,530 @@
+#include <cstring>
+#include "main.h"
+
+/*
+  Flat, structure-of-arrays representation of all primitive gates in a
+  System. Composite components are dissolved into the gates they consist
+  of, and every wire that is connected to a gate becomes a net that is
+  addressed by a 32-bit index.
+
+  Net 0 is the constant 0 that unconnected gate inputs read, and net 1
+  is where unconnected gate outputs go. The wire of every other net is
+  kept so the nets can be mapped back to their hierarchical names.
+
+  Before the fanout is built, gates whose output can never change are
+  removed, as well as gates whose output is neither an output, counted,
+  nor read by a gate that is kept. The nets of removed gates keep their
+  values, so they never toggle.
+
+  The same happens when a netlist is specialized for source nets that are
+  held at their current values, which leaves a smaller residual netlist
+  over the same nets.
+*/
+
+static const string const_0_name = "<const 0>";
+static const string open_name = "<open>";
+
+void Netlist::Elaborate(const System &system) {
+	const auto &gates = system.GetLevelizedGates();
+
+	// Only wires that System knows about count towards the toggles.
+	unordered_set<const Wire *> counted_wires;
+	for (const auto &[name, wire] : system.GetWires()) {
+		if (wire) {
+			counted_wires.insert(wire.get());
+		}
+	}
+
+	gate_types.clear();
+	gate_outputs.clear();
+	gate_levels.clear();
+	gate_names.clear();
+	fanin_offsets.clear();
+	fanin_nets.clear();
+	net_wires = {nullptr, nullptr};
+	toggle_weights = {0, 0};
+	source_nets.clear();
+	output_nets.clear();
+	wire_to_net.clear();
+
+	auto add_net = [&](const wire_t &wire) {
+		const auto it = wire_to_net.find(wire.get());
+		if (it != wire_to_net.end()) {
+			return it->second;
+		}
+
+		const uint32_t net = net_wires.size();
+		wire_to_net[wire.get()] = net;
+		net_wires.push_back(wire);
+
+		if (counted_wires.find(wire.get()) != counted_wires.end()) {
+			toggle_weights.push_back(wire->GetNumOutputs());
+		} else {
+			toggle_weights.push_back(0);
+		}
+
+		if (wire->IsOutputWire()) {
+			output_nets.push_back(net);
+		}
+
+		return net;
+	};
+
+	// The input ports of each gate, in the order Evaluate() reads them.
+	vector<vector<PORTS>> input_ports;
+	input_ports.reserve(gates.size());
+
+	for (const auto &gate : gates) {
+		const auto primitive = IdentifyGate(gate);
+
+		if (!primitive) {
+			Error("Component \"" + gate->GetName() + "\" is not a primitive gate, so it cannot be elaborated.\n");
+		}
+
+		gate_types.push_back(primitive->first);
+		input_ports.push_back(primitive->second);
+		gate_levels.push_back(gate->GetLevel());
+		gate_names.push_back(gate->GetName());
+	}
+
+	// Nets that are not driven by a gate come first, followed by the
+	// gate outputs in level order.
+	for (size_t g = 0; g < gates.size(); ++g) {
+		for (const auto &port : input_ports[g]) {
+			const auto &wire = gates[g]->GetWire(port);
+
+			if (wire && !wire->GetComponentInput() &&
+				wire_to_net.find(wire.get()) == wire_to_net.end()) {
+				source_nets.push_back(add_net(wire));
+			}
+		}
+	}
+
+	for (const auto &gate : gates) {
+		const auto &wire = gate->GetWire(PORTS::O);
+		gate_outputs.push_back(wire ? add_net(wire) : OPEN);
+	}
+
+	// The wires of source nets count their own toggles when the stimuli
+	// are applied.
+	for (const auto &net : source_nets) {
+		toggle_weights[net] = 0;
+	}
+
+	fanin_offsets.push_back(0);
+	for (size_t g = 0; g < gates.size(); ++g) {
+		for (const auto &port : input_ports[g]) {
+			const auto &wire = gates[g]->GetWire(port);
+
+			if (!wire) {
+				fanin_nets.push_back(CONST_0);
+				continue;
+			}
+
+			const auto it = wire_to_net.find(wire.get());
+			if (it == wire_to_net.end()) {
+				Error("Wire \"" + wire->GetName() + "\" of component \"" + gates[g]->GetName()
+					  + "\" is not driven by a gate, so the netlist cannot be elaborated.\n");
+			}
+			fanin_nets.push_back(it->second);
+		}
+		fanin_offsets.push_back(fanin_nets.size());
+	}
+
+	// Stimuli can only be applied to wires that the configuration can
+	// name, so all other source nets keep their current value.
+	unordered_set<const Wire *> visible_wires = counted_wires;
+	for (const auto &wire : system.GetAllInputWires()) {
+		visible_wires.insert(wire.get());
+	}
+
+	constant_nets.clear();
+	for (const auto &net : source_nets) {
+		if (visible_wires.find(net_wires[net].get()) == visible_wires.end()) {
+			constant_nets.push_back(net);
+		}
+	}
+
+	vector<uint8_t> values(net_wires.size(), 0);
+	for (size_t n = 0; n < net_wires.size(); ++n) {
+		if (net_wires[n]) {
+			values[n] = net_wires[n]->GetValue();
+		}
+	}
+
+	vector<uint8_t> keep(GetNumGates(), true);
+	num_constant_gates = RemoveConstantGates(constant_nets, values, keep);
+	num_dead_gates = RemoveUnobservedGates(keep);
+	num_held_gates = 0;
+	RemoveGates(keep);
+
+	// Levels go from 0 to the number of levels of the system.
+	BuildFanout();
+	BuildDrivenNets();
+	BuildLevels(system.GetNumLevels() + 1);
+}
+
+// Turns a copy of the full netlist into the residual netlist that is left
+// when the held source nets keep the values they have in the state. The
+// nets stay the same, so the state can be used with either netlist.
+//
+// Call this after the held values have been simulated with the full
+// netlist. Every gate that only depends on held and constant nets has
+// then settled to its constant value, so removing it does not change the
+// toggles, and its net is up to date when the full netlist is used again.
+// Gates that are not observed are kept, as they would not be up to date.
+void Netlist::Specialize(const Netlist &full, const vector<uint32_t> &held_nets, const NetState &state) {
+	*this = full;
+
+	vector<uint32_t> fixed_nets = constant_nets;
+	fixed_nets.insert(fixed_nets.end(), held_nets.begin(), held_nets.end());
+
+	vector<uint8_t> keep(GetNumGates(), true);
+	num_held_gates = RemoveConstantGates(fixed_nets, state.values, keep);
+	RemoveGates(keep);
+
+	BuildFanout();
+	BuildDrivenNets();
+	BuildLevels(GetNumLevels());
+}
+
+// Marks the gates whose output can never change when the given source
+// nets keep their values, and returns how many there are. The values of
+// the other nets are only used to check that a gate output already has
+// its constant value.
+size_t Netlist::RemoveConstantGates(const vector<uint32_t> &fixed_nets, const vector<uint8_t> &values, vector<uint8_t> &keep) const {
+	const size_t num_gates = gate_types.size();
+	constexpr uint8_t UNKNOWN = 2;
+	size_t num_removed = 0;
+
+	// The value of each net that can never change.
+	vector<uint8_t> constant(net_wires.size(), UNKNOWN);
+	constant[CONST_0] = 0;
+
+	for (const auto &net : fixed_nets) {
+		constant[net] = values[net];
+	}
+
+	// Gates are in level order, so their inputs are done before them.
+	for (uint32_t gate = 0; gate < num_gates; ++gate) {
+		const uint32_t *in = GetFanin(gate);
+		const size_t num_inputs = GetFaninSize(gate);
+		uint8_t in_values[3];
+		bool all_known = true;
+		bool any_0 = false;
+		bool any_1 = false;
+
+		for (size_t i = 0; i < num_inputs; ++i) {
+			in_values[i] = constant[in[i]];
+			all_known &= in_values[i] != UNKNOWN;
+			any_0 |= in_values[i] == 0;
+			any_1 |= in_values[i] == 1;
+		}
+
+		uint8_t value = UNKNOWN;
+
+		if (all_known) {
+			Evaluate(gate, constant.data(), value);
+		} else {
+			// A controlling value fixes the output on its own.
+			switch (gate_types[gate]) {
+			case GATE::AND:
+			case GATE::AND3: value = any_0 ? 0 : UNKNOWN; break;
+			case GATE::NAND: value = any_0 ? 1 : UNKNOWN; break;
+			case GATE::OR:
+			case GATE::OR3:  value = any_1 ? 1 : UNKNOWN; break;
+			case GATE::NOR:
+			case GATE::NOR3: value = any_1 ? 0 : UNKNOWN; break;
+			case GATE::MUX:
+				if (in_values[2] != UNKNOWN) {
+					value = in_values[in_values[2] ? 1 : 0];
+				} else if (in_values[0] == in_values[1]) {
+					value = in_values[0];
+				}
+				break;
+			default: break;
+			}
+		}
+
+		// The net only stays constant if it already has that value,
+		// otherwise it toggles once when it is next updated.
+		const uint32_t out = gate_outputs[gate];
+		if (value != UNKNOWN && (out == OPEN || values[out] == value)) {
+			if (out != OPEN) {
+				constant[out] = value;
+			}
+
+			keep[gate] = false;
+			num_removed++;
+		}
+	}
+
+	return num_removed;
+}
+
+// Marks the gates whose output is neither an output, counted, nor read by
+// a gate that is kept, and returns how many there are.
+size_t Netlist::RemoveUnobservedGates(vector<uint8_t> &keep) const {
+	const size_t num_nets = net_wires.size();
+	size_t num_removed = 0;
+
+	vector<uint8_t> observed(num_nets, false);
+	for (const auto &net : output_nets) {
+		observed[net] = true;
+	}
+	for (size_t n = 0; n < num_nets; ++n) {
+		observed[n] = observed[n] || toggle_weights[n] > 0;
+	}
+
+	for (uint32_t gate = gate_types.size(); gate-- > 0;) {
+		if (!keep[gate]) {
+			continue;
+		}
+
+		if (!observed[gate_outputs[gate]]) {
+			keep[gate] = false;
+			num_removed++;
+			continue;
+		}
+
+		const uint32_t *in = GetFanin(gate);
+		for (size_t i = 0; i < GetFaninSize(gate); ++i) {
+			observed[in[i]] = true;
+		}
+	}
+
+	return num_removed;
+}
+
+// Compacts the gates that are kept. Their order does not change.
+void Netlist::RemoveGates(const vector<uint8_t> &keep) {
+	const size_t num_gates = gate_types.size();
+	vector<uint32_t> offsets = {0};
+	vector<uint32_t> nets;
+	size_t kept = 0;
+
+	for (uint32_t gate = 0; gate < num_gates; ++gate) {
+		if (!keep[gate]) {
+			continue;
+		}
+
+		nets.insert(nets.end(), GetFanin(gate), GetFanin(gate) + GetFaninSize(gate));
+		offsets.push_back(nets.size());
+
+		gate_types[kept] = gate_types[gate];
+		gate_outputs[kept] = gate_outputs[gate];
+		gate_levels[kept] = gate_levels[gate];
+		gate_names[kept] = move(gate_names[gate]);
+		kept++;
+	}
+
+	gate_types.resize(kept);
+	gate_outputs.resize(kept);
+	gate_levels.resize(kept);
+	gate_names.resize(kept);
+	fanin_offsets = move(offsets);
+	fanin_nets = move(nets);
+}
+
+// Builds the fanout of each net. A gate that reads the same net on
+// several ports is only added once.
+void Netlist::BuildFanout() {
+	vector<vector<uint32_t>> fanouts(net_wires.size());
+
+	for (uint32_t g = 0; g < GetNumGates(); ++g) {
+		for (size_t i = fanin_offsets[g]; i < fanin_offsets[g + 1]; ++i) {
+			const uint32_t net = fanin_nets[i];
+			auto &fanout = fanouts[net];
+
+			if (net != CONST_0 && (fanout.empty() || fanout.back() != g)) {
+				fanout.push_back(g);
+			}
+		}
+	}
+
+	fanout_offsets.assign(1, 0);
+	fanout_gates.clear();
+	for (const auto &fanout : fanouts) {
+		fanout_gates.insert(fanout_gates.end(), fanout.begin(), fanout.end());
+		fanout_offsets.push_back(fanout_gates.size());
+	}
+}
+
+void Netlist::BuildDrivenNets() {
+	driven_nets.assign((net_wires.size() + 63) / 64, 0);
+
+	for (const auto &net : gate_outputs) {
+		if (net != OPEN) {
+			driven_nets[net / 64] |= 1ULL << (net % 64);
+		}
+	}
+}
+
+// Gates are already sorted by level, so each level is a contiguous range.
+void Netlist::BuildLevels(size_t num_levels) {
+	level_offsets.assign(num_levels + 1, 0);
+	for (const auto &level : gate_levels) {
+		level_offsets[level + 1]++;
+	}
+	for (size_t l = 1; l < level_offsets.size(); ++l) {
+		level_offsets[l] += level_offsets[l - 1];
+	}
+}
+
+// Returns the type of a primitive gate, and its input ports in the order
+// Evaluate() reads them, or nothing if the component is not a primitive
+// gate.
+const optional<pair<Netlist::GATE, vector<PORTS>>> Netlist::IdentifyGate(const comp_t &component) {
+	if (dynamic_pointer_cast<And>(component)) {
+		return {{GATE::AND, {PORTS::A, PORTS::B}}};
+	} else if (dynamic_pointer_cast<And3>(component)) {
+		return {{GATE::AND3, {PORTS::A, PORTS::B, PORTS::C}}};
+	} else if (dynamic_pointer_cast<Or>(component)) {
+		return {{GATE::OR, {PORTS::A, PORTS::B}}};
+	} else if (dynamic_pointer_cast<Or3>(component)) {
+		return {{GATE::OR3, {PORTS::A, PORTS::B, PORTS::C}}};
+	} else if (dynamic_pointer_cast<Xor>(component)) {
+		return {{GATE::XOR, {PORTS::A, PORTS::B}}};
+	} else if (dynamic_pointer_cast<Nand>(component)) {
+		return {{GATE::NAND, {PORTS::A, PORTS::B}}};
+	} else if (dynamic_pointer_cast<Nor>(component)) {
+		return {{GATE::NOR, {PORTS::A, PORTS::B}}};
+	} else if (dynamic_pointer_cast<Nor3>(component)) {
+		return {{GATE::NOR3, {PORTS::A, PORTS::B, PORTS::C}}};
+	} else if (dynamic_pointer_cast<Xnor>(component)) {
+		return {{GATE::XNOR, {PORTS::A, PORTS::B}}};
+	} else if (dynamic_pointer_cast<Not>(component)) {
+		return {{GATE::NOT, {PORTS::I}}};
+	} else if (dynamic_pointer_cast<Mux>(component)) {
+		return {{GATE::MUX, {PORTS::A, PORTS::B, PORTS::S}}};
+	} else {
+		return nullopt;
+	}
+}
+
+// Collects the primitive gates of a component, expanding the composite
+// components it contains. Returns false if one of them is neither.
+const bool Netlist::CollectGates(const comp_t &component, vector<comp_t> &gates) {
+	const auto subcomponents = component->GetSubcomponents();
+
+	if (subcomponents.empty()) {
+		if (!IdentifyGate(component)) {
+			return false;
+		}
+
+		gates.push_back(component);
+		return true;
+	}
+
+	for (const auto &c : subcomponents) {
+		if (c && !CollectGates(c, gates)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Copies the current values of the wires into the state.
+void Netlist::InitState(NetState &state) const {
+	const size_t num_nets = net_wires.size();
+
+	state.values.assign(num_nets, 0);
+	state.toggles.assign(num_nets, 0);
+	state.num_toggles = 0;
+
+	for (size_t n = 0; n < num_nets; ++n) {
+		if (net_wires[n]) {
+			state.values[n] = net_wires[n]->GetValue();
+		}
+	}
+}
+
+// Reads the values of the nets that are not driven by a gate from their
+// wires, since those are set by the stimuli.
+void Netlist::LoadSources(NetState &state) const {
+	for (const auto &net : source_nets) {
+		state.values[net] = net_wires[net]->GetValue();
+	}
+}
+
+// Writes the values of the output nets back to their wires, so that the
+// output wire bundles can be read as usual.
+void Netlist::StoreOutputs(const NetState &state) const {
+	for (const auto &net : output_nets) {
+		net_wires[net]->SyncValue(state.values[net]);
+	}
+}
+
+// Packs the values of 64 nets into a word, one bit per net. Every value is
+// 0 or 1, so the multiplication moves the lowest bit of each of 8 bytes
+// into the highest byte without any carries.
+static inline const uint64_t PackValues(const uint8_t *values, size_t count) {
+	uint64_t word = 0;
+
+	for (size_t b = 0; b < count; b += 8) {
+		uint64_t bytes = 0;
+		memcpy(&bytes, values + b, min((size_t)8, count - b));
+		word |= ((bytes * 0x0102040810204080ULL) >> 56) << b;
+	}
+
+	return word;
+}
+
+// Takes the current values of the nets as the committed ones.
+void Netlist::InitCommitted(NetState &state) const {
+	const size_t num_nets = state.values.size();
+
+	state.committed.resize((num_nets + 63) / 64);
+
+	for (size_t w = 0; w < state.committed.size(); ++w) {
+		state.committed[w] = PackValues(&state.values[w * 64], min((size_t)64, num_nets - w * 64));
+	}
+}
+
+// Commits the values of the nets that the gates have settled to. The nets
+// that changed since the last commit are the bits in which the packed
+// values differ, and each of them that a gate drives toggled once.
+void Netlist::Commit(NetState &state) const {
+	const size_t num_nets = state.values.size();
+
+	for (size_t w = 0; w < state.committed.size(); ++w) {
+		const uint64_t word = PackValues(&state.values[w * 64], min((size_t)64, num_nets - w * 64));
+		uint64_t toggled = (state.committed[w] ^ word) & driven_nets[w];
+
+		state.committed[w] = word;
+
+		while (toggled) {
+			const uint32_t net = w * 64 + __builtin_ctzll(toggled);
+
+			state.toggles[net]++;
+			state.num_toggles += toggle_weights[net];
+			toggled &= toggled - 1;
+		}
+	}
+}
+
+const bool Netlist::IsGateOutput(const wire_t &wire) const {
+	const auto net = GetNet(wire);
+	return net && net.value() >= source_nets.size() + 2;
+}
+
+const string &Netlist::GetNetName(uint32_t net) const {
+	if (net_wires[net]) {
+		return net_wires[net]->GetName();
+	} else if (net == CONST_0) {
+		return const_0_name;
+	} else {
+		return open_name;
+	}
+}
+
+const optional<uint32_t> Netlist::GetNet(const wire_t &wire) const {
+	const auto it = wire_to_net.find(wire.get());
+
+	if (it != wire_to_net.end()) {
+		return it->second;
+	} else {
+		return nullopt;
+	}
+}
@@ -0,0 +1,129 @@
+#ifndef NETLIST_H
+#define NETLIST_H
+
+#include "main.h"
+
+// Value and toggle count of every net of a Netlist.
+struct NetState {
+	vector<uint8_t> values;
+	vector<size_t> toggles; // Number of times each net changed value.
+	size_t num_toggles = 0; // Sum of all toggles, weighted like Wire does.
+
+	// The values of the nets when they were last committed, one bit per net.
+	vector<uint64_t> committed;
+};
+
+class Netlist {
+public:
+	enum class GATE : uint8_t {AND, AND3, OR, OR3, XOR, NAND, NOR, NOR3, XNOR, NOT, MUX};
+
+	static constexpr uint32_t CONST_0 = 0; // Net of unconnected inputs.
+	static constexpr uint32_t OPEN = 1;    // Net of unconnected outputs.
+
+	void Elaborate(const System &system);
+	void Specialize(const Netlist &full, const vector<uint32_t> &held_nets, const NetState &state);
+	void InitState(NetState &state) const;
+	void LoadSources(NetState &state) const;
+	void StoreOutputs(const NetState &state) const;
+	void InitCommitted(NetState &state) const;
+	void Commit(NetState &state) const;
+
+	const size_t GetNumGates() const {return gate_types.size();}
+	const size_t GetNumConstantGates() const {return num_constant_gates;}
+	const size_t GetNumDeadGates() const {return num_dead_gates;}
+	const size_t GetNumHeldGates() const {return num_held_gates;}
+	const size_t GetNumNets() const {return net_wires.size();}
+	const size_t GetNumLevels() const {return level_offsets.size() - 1;}
+	const GATE GetGateType(uint32_t gate) const {return gate_types[gate];}
+	const uint32_t GetGateOutput(uint32_t gate) const {return gate_outputs[gate];}
+	const uint32_t GetGateLevel(uint32_t gate) const {return gate_levels[gate];}
+	const uint32_t *GetFanin(uint32_t gate) const {return &fanin_nets[fanin_offsets[gate]];}
+	const size_t GetFaninSize(uint32_t gate) const {return fanin_offsets[gate + 1] - fanin_offsets[gate];}
+	const uint32_t *GetFanout(uint32_t net) const {return &fanout_gates[fanout_offsets[net]];}
+	const size_t GetFanoutSize(uint32_t net) const {return fanout_offsets[net + 1] - fanout_offsets[net];}
+	const uint32_t GetLevelBegin(size_t level) const {return level_offsets[level];}
+	const uint32_t GetLevelEnd(size_t level) const {return level_offsets[level + 1];}
+	const size_t GetToggleWeight(uint32_t net) const {return toggle_weights[net];}
+	const vector<uint32_t> &GetSourceNets() const {return source_nets;}
+	const vector<uint32_t> &GetOutputNets() const {return output_nets;}
+	const string &GetGateName(uint32_t gate) const {return gate_names[gate];}
+	const string &GetNetName(uint32_t net) const;
+	const wire_t &GetNetWire(uint32_t net) const {return net_wires[net];}
+	const optional<uint32_t> GetNet(const wire_t &wire) const;
+	const bool IsGateOutput(const wire_t &wire) const;
+
+	// Evaluates a gate using the values of the nets it is connected to. Net
+	// values are either single bits stored as 0 or 1 in a uint8_t, or words
+	// of which every bit belongs to a different stimulus. It is always
+	// inlined, so that SIMD words are evaluated with the instruction set of
+	// the caller, and returns through a reference so that no SIMD word is
+	// passed by value.
+	template <typename T>
+	__attribute__((always_inline)) inline void Evaluate(uint32_t gate, const T *values, T &result) const {
+		Evaluate(gate_types[gate], GetFanin(gate), values, result);
+	}
+
+	// Same as above, for a gate of the given type that reads the nets in.
+	template <typename T>
+	__attribute__((always_inline)) static inline void Evaluate(GATE type, const uint32_t *in, const T *values, T &result) {
+		T ones;
+		if constexpr (is_same<T, uint8_t>::value) {
+			ones = 1;
+		} else {
+			ones = ~T{};
+		}
+
+		switch (type) {
+		case GATE::AND:  result = values[in[0]] & values[in[1]]; break;
+		case GATE::AND3: result = values[in[0]] & values[in[1]] & values[in[2]]; break;
+		case GATE::OR:   result = values[in[0]] | values[in[1]]; break;
+		case GATE::OR3:  result = values[in[0]] | values[in[1]] | values[in[2]]; break;
+		case GATE::XOR:  result = values[in[0]] ^ values[in[1]]; break;
+		case GATE::NAND: result = (values[in[0]] & values[in[1]]) ^ ones; break;
+		case GATE::NOR:  result = (values[in[0]] | values[in[1]]) ^ ones; break;
+		case GATE::NOR3: result = (values[in[0]] | values[in[1]] | values[in[2]]) ^ ones; break;
+		case GATE::XNOR: result = (values[in[0]] ^ values[in[1]]) ^ ones; break;
+		case GATE::NOT:  result = values[in[0]] ^ ones; break;
+		case GATE::MUX:  result = (values[in[0]] & (values[in[2]] ^ ones)) | (values[in[1]] & values[in[2]]); break;
+		}
+	}
+
+	static const optional<pair<GATE, vector<PORTS>>> IdentifyGate(const comp_t &component);
+	static const bool CollectGates(const comp_t &component, vector<comp_t> &gates);
+
+private:
+	size_t RemoveConstantGates(const vector<uint32_t> &fixed_nets, const vector<uint8_t> &values, vector<uint8_t> &keep) const;
+	size_t RemoveUnobservedGates(vector<uint8_t> &keep) const;
+	void RemoveGates(const vector<uint8_t> &keep);
+	void BuildFanout();
+	void BuildDrivenNets();
+	void BuildLevels(size_t num_levels);
+
+	// Gates are stored in level order.
+	vector<GATE> gate_types;
+	vector<uint32_t> gate_outputs;
+	vector<uint32_t> gate_levels;
+	vector<uint32_t> level_offsets; // Gates of level l are in [level_offsets[l], level_offsets[l + 1]).
+	vector<string> gate_names;
+
+	// Compressed sparse row indices from gates to the nets they read,
+	// in port order, and from nets to the gates that read them.
+	vector<uint32_t> fanin_offsets;
+	vector<uint32_t> fanin_nets;
+	vector<uint32_t> fanout_offsets;
+	vector<uint32_t> fanout_gates;
+
+	vector<wire_t> net_wires;          // The wire of each net, nullptr for CONST_0 and OPEN.
+	vector<size_t> toggle_weights;     // Number of outputs of a net, or 0 if it is not counted here.
+	vector<uint32_t> source_nets;      // Nets that are not driven by any gate, like the inputs.
+	vector<uint32_t> output_nets;      // Nets of output wires.
+	vector<uint32_t> constant_nets;    // Source nets that no stimulus can change.
+	vector<uint64_t> driven_nets;      // Bit n is set if a gate drives net n, except for OPEN.
+	unordered_map<const Wire *, uint32_t> wire_to_net;
+
+	size_t num_constant_gates = 0; // Gates removed because their output never changes.
+	size_t num_dead_gates = 0;     // Gates removed because nothing observes their output.
+	size_t num_held_gates = 0;     // Gates removed because held source nets fix their output.
+};
+
+#endif // NETLIST_H
@@ -0,0 +1,511 @@
+#include <immintrin.h>
+#include "main.h"
+
+/*
+  Zero-delay simulation of up to 512 patterns at once.
+
+  The values of the nets only depend on the values of the sources, so
+  consecutive patterns are independent of each other. Each net is stored
+  as a 512-bit word of which bit i holds its value for pattern i, and each
+  gate is evaluated with a few bitwise operations on these words.
+
+  Pattern i toggles a net if bit i differs from bit i - 1, or from the
+  last pattern of the previous batch for i = 0. Patterns that are not
+  used in a batch repeat the last used one, so they never toggle.
+
+  The kernel is written once with GCC vector extensions and compiled for
+  SSE2, AVX2, and AVX-512. The best one that the CPU supports is picked
+  at runtime. With AVX-512, three-input gates compile to VPTERNLOGQ.
+
+  With a thread pool, the gates of a wide level are split into tasks for
+  the threads of the pool. All gates of a level only read nets of lower
+  levels, so the tasks are independent, and each level waits for the one
+  before it to finish.
+
+  With a unit delay, the output of a gate at time step k is a function of
+  its inputs at step k - 1. The settled values of all patterns are
+  computed first, as with zero delay. Bit i of every gate output then
+  starts from the settled value of pattern i - 1, while the sources
+  already have the values of pattern i. All patterns advance in lock-step,
+  one time step at a time, until no net changes anymore. Every change is
+  counted, and the difference with the zero-delay toggles of a pattern
+  are its glitches. A gate is only evaluated in a step if one of its
+  inputs changed in the step before, for any pattern.
+*/
+
+using word_t = PatternParallel::word_t;
+
+__attribute__((always_inline))
+static inline const bool AnySet(const word_t &word) {
+	uint64_t any = 0;
+
+	for (size_t i = 0; i < PatternParallel::NUM_WORDS; ++i) {
+		any |= word[i];
+	}
+
+	return any != 0;
+}
+
+// Sets bit i of result to bit i - 1 of value, and bit 0 to the last bit
+// of previous. Like Netlist::Evaluate(), it returns through a reference so
+// that no SIMD word is passed by value.
+__attribute__((always_inline))
+static inline void PreviousPatterns(const word_t &previous, const word_t &value, word_t &result) {
+	const word_t shifted = __builtin_shuffle(previous, value, word_t{7, 8, 9, 10, 11, 12, 13, 14});
+	result = (value << 1) | (shifted >> 63);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static inline const size_t PopCountVPOPCNT(const word_t &word) {
+	return _mm512_reduce_add_epi64(_mm512_popcnt_epi64((__m512i)word));
+}
+
+void PatternParallel::Init(const Netlist &_netlist, const NetState &state) {
+	netlist = &_netlist;
+	words.resize(netlist->GetNumNets());
+	Prime(state);
+
+	source_words.assign(netlist->GetSourceNets().size(), word_t{});
+	num_patterns = 0;
+	net_toggles.assign(netlist->GetNumNets(), 0);
+	scheduled_at.assign(netlist->GetNumGates(), 0);
+
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq")) {
+		kernel = KERNEL::AVX512_VPOPCNT;
+	} else if (__builtin_cpu_supports("avx512f")) {
+		kernel = KERNEL::AVX512;
+	} else if (__builtin_cpu_supports("avx2")) {
+		kernel = KERNEL::AVX2;
+	} else {
+		kernel = KERNEL::SSE2;
+	}
+}
+
+// Captures the current values of the source wires as the next pattern.
+void PatternParallel::AddPattern() {
+	const auto &sources = netlist->GetSourceNets();
+	const size_t word_idx = num_patterns / WORD_SIZE;
+	const uint64_t bit = 1ULL << (num_patterns % WORD_SIZE);
+
+	for (size_t i = 0; i < sources.size(); ++i) {
+		if (netlist->GetNetWire(sources[i])->GetValue()) {
+			source_words[i][word_idx] |= bit;
+		}
+	}
+
+	num_patterns++;
+}
+
+// Captures a pattern with the given values of the source nets instead of
+// the values of their wires.
+void PatternParallel::AddPattern(const vector<uint8_t> &source_values) {
+	const size_t word_idx = num_patterns / WORD_SIZE;
+	const uint64_t bit = 1ULL << (num_patterns % WORD_SIZE);
+
+	for (size_t i = 0; i < source_values.size(); ++i) {
+		if (source_values[i]) {
+			source_words[i][word_idx] |= bit;
+		}
+	}
+
+	num_patterns++;
+}
+
+// Sets the values of the nets before the first pattern of the batch to
+// the values in the state.
+void PatternParallel::Prime(const NetState &state) {
+	for (size_t n = 0; n < words.size(); ++n) {
+		words[n] = state.values[n] ? ~word_t{} : word_t{};
+	}
+}
+
+// Sets the values of the nets before the first pattern of the batch to
+// the values of the last pattern of another batch. Only that pattern is
+// evaluated, so batches can be primed without waiting for each other.
+void PatternParallel::Prime(const PatternParallel &previous) {
+	const auto &sources = netlist->GetSourceNets();
+	const size_t last = previous.num_patterns - 1;
+
+	// Nets that no gate drives, like the outputs of removed constant
+	// gates, keep the value they already have.
+	prime_values.resize(words.size());
+	for (size_t n = 0; n < words.size(); ++n) {
+		prime_values[n] = words[n][0] & 1;
+	}
+
+	for (size_t i = 0; i < sources.size(); ++i) {
+		prime_values[sources[i]] = (previous.source_words[i][last / WORD_SIZE] >> (last % WORD_SIZE)) & 1;
+	}
+
+	for (uint32_t gate = 0; gate < netlist->GetNumGates(); ++gate) {
+		netlist->Evaluate(gate, prime_values.data(), prime_values[netlist->GetGateOutput(gate)]);
+	}
+
+	for (size_t n = 0; n < words.size(); ++n) {
+		words[n] = prime_values[n] ? ~word_t{} : word_t{};
+	}
+}
+
+// Splits the levels that are at least MIN_PARALLEL_LEVEL_WIDTH gates wide
+// over the threads of the pool. The other levels are evaluated by the
+// calling thread.
+void PatternParallel::SetThreadPool(ThreadPool *_pool, const vector<size_t> &level_widths) {
+	pool = _pool;
+	parallel_levels.assign(level_widths.size(), 0);
+
+	if (pool && pool->GetNumThreads() > 1) {
+		for (size_t l = 0; l < level_widths.size(); ++l) {
+			parallel_levels[l] = level_widths[l] >= MIN_PARALLEL_LEVEL_WIDTH;
+		}
+	}
+
+	counters.resize(pool ? pool->GetNumThreads() : 1);
+}
+
+// Fills the unused patterns with the last one, so they do not toggle.
+// Call this before Prime() reads the last pattern of this batch from
+// another thread, as the batch is not changed while it is evaluated.
+void PatternParallel::FillUnusedPatterns() {
+	if (num_patterns == 0) {
+		return;
+	}
+
+	const size_t last = num_patterns - 1;
+
+	for (auto &value : source_words) {
+		const uint64_t fill = ((value[last / WORD_SIZE] >> (last % WORD_SIZE)) & 1) ? ~0ULL : 0ULL;
+
+		for (size_t i = 0; i < NUM_WORDS; ++i) {
+			uint64_t unused = 0;
+
+			if (i * WORD_SIZE >= num_patterns) {
+				unused = ~0ULL;
+			} else if ((i + 1) * WORD_SIZE > num_patterns) {
+				unused = ~0ULL << (num_patterns % WORD_SIZE);
+			}
+
+			value[i] = (value[i] & ~unused) | (fill & unused);
+		}
+	}
+}
+
+// Evaluates all captured patterns, after FillUnusedPatterns(). Afterwards
+// the toggles of each pattern can be retrieved with GetToggles().
+void PatternParallel::Evaluate() {
+	if (num_patterns == 0) {
+		return;
+	}
+
+	for (auto &c : counters) {
+		for (auto &bits : c.bits) {
+			bits = word_t{};
+		}
+	}
+
+	if (unit_delay) {
+		EvaluateUnitDelay();
+		return;
+	}
+
+	// Source nets are not counted here, so they never add to the counters.
+	const auto &sources = netlist->GetSourceNets();
+	for (size_t i = 0; i < sources.size(); ++i) {
+		Commit<KERNEL::SSE2>(sources[i], source_words[i], counters[0]);
+	}
+
+	// Gates are stored in level order, so consecutive levels that are not
+	// split over the threads are evaluated as a single range.
+	uint32_t serial_begin = 0;
+
+	for (size_t l = 0; l < parallel_levels.size(); ++l) {
+		if (!parallel_levels[l]) {
+			continue;
+		}
+
+		const uint32_t begin = netlist->GetLevelBegin(l);
+		const uint32_t end = netlist->GetLevelEnd(l);
+		const size_t num_tasks = (end - begin + GATES_PER_TASK - 1) / GATES_PER_TASK;
+
+		EvaluateGates(serial_begin, begin, counters[0]);
+		pool->Run(num_tasks, [&](size_t task, size_t thread) {
+			const uint32_t task_begin = begin + task * GATES_PER_TASK;
+			EvaluateGates(task_begin, min<uint32_t>(task_begin + GATES_PER_TASK, end), counters[thread]);
+		});
+		serial_begin = end;
+	}
+
+	EvaluateGates(serial_begin, netlist->GetNumGates(), counters[0]);
+	ReadCounters(pattern_toggles);
+}
+
+// Evaluates all captured patterns with a unit delay for every gate.
+void PatternParallel::EvaluateUnitDelay() {
+	const auto &sources = netlist->GetSourceNets();
+
+	// The values before the batch, of which only the last pattern is used.
+	initial_words = words;
+
+	// Compute the settled values, and count their toggles per pattern.
+	count_net_toggles = false;
+	for (size_t i = 0; i < sources.size(); ++i) {
+		Commit<KERNEL::SSE2>(sources[i], source_words[i], counters[0]);
+	}
+	EvaluateGates(0, netlist->GetNumGates(), counters[0]);
+	count_net_toggles = true;
+
+	ReadCounters(pattern_glitches);
+	for (auto &bits : counters[0].bits) {
+		bits = word_t{};
+	}
+
+	// Rewind the gate outputs to the settled values of the previous
+	// patterns, and start with the gates that read a source that changed.
+	for (uint32_t gate = 0; gate < netlist->GetNumGates(); ++gate) {
+		const uint32_t out = netlist->GetGateOutput(gate);
+
+		if (out != Netlist::OPEN) {
+			PreviousPatterns(initial_words[out], words[out], words[out]);
+		}
+	}
+
+	for (const auto &net : sources) {
+		word_t previous;
+		PreviousPatterns(initial_words[net], words[net], previous);
+
+		if (AnySet(words[net] ^ previous)) {
+			ScheduleFanout(net);
+		}
+	}
+
+	while (true) {
+		swap(step_gates, next_step_gates);
+		next_step_gates.clear();
+		++step;
+
+		if (step_gates.empty()) {
+			break;
+		}
+
+		step_values.resize(step_gates.size());
+		StepGates(counters[0]);
+	}
+
+	// The settled toggles were stored in pattern_glitches, so subtract
+	// them from the total to get the glitches.
+	ReadCounters(pattern_toggles);
+	for (size_t p = 0; p < NUM_LANES; ++p) {
+		pattern_glitches[p] = pattern_toggles[p] - pattern_glitches[p];
+	}
+}
+
+// Schedules all gates that read the given net for the next time step.
+void PatternParallel::ScheduleFanout(uint32_t net) {
+	const uint32_t *fanout = netlist->GetFanout(net);
+	const size_t fanout_size = netlist->GetFanoutSize(net);
+
+	for (size_t i = 0; i < fanout_size; ++i) {
+		const uint32_t gate = fanout[i];
+
+		if (scheduled_at[gate] != step + 1) {
+			scheduled_at[gate] = step + 1;
+			next_step_gates.push_back(gate);
+		}
+	}
+}
+
+// Stores the weighted number of toggles of each pattern, summed over the
+// counters of all threads.
+void PatternParallel::ReadCounters(size_t *toggles) const {
+	for (size_t p = 0; p < NUM_LANES; ++p) {
+		const size_t word_idx = p / WORD_SIZE;
+		const size_t bit_idx = p % WORD_SIZE;
+		size_t count = 0;
+
+		for (const auto &c : counters) {
+			size_t thread_count = 0;
+
+			for (size_t k = 0; k < COUNTER_BITS; ++k) {
+				thread_count |= ((c.bits[k][word_idx] >> bit_idx) & 1) << k;
+			}
+
+			count += thread_count;
+		}
+
+		toggles[p] = count;
+	}
+}
+
+void PatternParallel::EvaluateGates(uint32_t begin, uint32_t end, Counters &c) {
+	if (begin == end) {
+		return;
+	}
+
+	switch (kernel) {
+	case KERNEL::SSE2:           EvaluateSSE2(begin, end, c); break;
+	case KERNEL::AVX2:           EvaluateAVX2(begin, end, c); break;
+	case KERNEL::AVX512:         EvaluateAVX512(begin, end, c); break;
+	case KERNEL::AVX512_VPOPCNT: EvaluateAVX512_VPOPCNT(begin, end, c); break;
+	}
+}
+
+void PatternParallel::StepGates(Counters &c) {
+	switch (kernel) {
+	case KERNEL::SSE2:           StepSSE2(c); break;
+	case KERNEL::AVX2:           StepAVX2(c); break;
+	case KERNEL::AVX512:         StepAVX512(c); break;
+	case KERNEL::AVX512_VPOPCNT: StepAVX512_VPOPCNT(c); break;
+	}
+}
+
+// Adds the toggles of each net to the state, and resets them.
+void PatternParallel::MergeToggles(NetState &state) {
+	for (size_t n = 0; n < net_toggles.size(); ++n) {
+		state.toggles[n] += net_toggles[n];
+		net_toggles[n] = 0;
+	}
+}
+
+// Drops the captured patterns, so a new batch can be started.
+void PatternParallel::Clear() {
+	fill(source_words.begin(), source_words.end(), word_t{});
+	num_patterns = 0;
+}
+
+const string PatternParallel::GetKernelName() const {
+	switch (kernel) {
+	case KERNEL::SSE2:           return "SSE2";
+	case KERNEL::AVX2:           return "AVX2";
+	case KERNEL::AVX512:         return "AVX-512";
+	case KERNEL::AVX512_VPOPCNT: return "AVX-512 with VPOPCNTQ";
+	}
+
+	return "";
+}
+
+// The kernel and its helpers are always inlined into the functions below,
+// so they are compiled for the instruction set of each of them.
+template <PatternParallel::KERNEL K>
+__attribute__((always_inline))
+inline void PatternParallel::EvaluateKernel(uint32_t begin, uint32_t end, Counters &c) {
+	// Gates are stored in level order, so their inputs are already done.
+	for (uint32_t gate = begin; gate < end; ++gate) {
+		word_t value;
+		netlist->Evaluate(gate, words.data(), value);
+		Commit<K>(netlist->GetGateOutput(gate), value, c);
+	}
+}
+
+// Evaluates the gates of a time step from the values of the previous
+// step, and only then updates their outputs.
+template <PatternParallel::KERNEL K>
+__attribute__((always_inline))
+inline void PatternParallel::StepKernel(Counters &c) {
+	for (size_t i = 0; i < step_gates.size(); ++i) {
+		netlist->Evaluate(step_gates[i], words.data(), step_values[i]);
+	}
+
+	for (size_t i = 0; i < step_gates.size(); ++i) {
+		const uint32_t net = netlist->GetGateOutput(step_gates[i]);
+		const word_t toggled = step_values[i] ^ words[net];
+
+		if (AnySet(toggled)) {
+			words[net] = step_values[i];
+			CountToggles<K>(net, toggled, c);
+			ScheduleFanout(net);
+		}
+	}
+}
+
+template <PatternParallel::KERNEL K>
+__attribute__((always_inline))
+inline void PatternParallel::Commit(uint32_t net, const word_t &value, Counters &c) {
+	// Bit i of the previous value holds the value of pattern i - 1,
+	// starting with the last pattern of the previous batch.
+	word_t previous;
+	PreviousPatterns(words[net], value, previous);
+	const word_t toggled = value ^ previous;
+
+	words[net] = value;
+	CountToggles<K>(net, toggled, c);
+}
+
+template <PatternParallel::KERNEL K>
+__attribute__((always_inline))
+inline void PatternParallel::CountToggles(uint32_t net, const word_t &toggled, Counters &c) {
+	if (AnySet(toggled)) {
+		if (count_net_toggles) {
+			size_t count = 0;
+
+			if constexpr (K == KERNEL::AVX512_VPOPCNT) {
+				count = PopCountVPOPCNT(toggled);
+			} else {
+				for (size_t i = 0; i < NUM_WORDS; ++i) {
+					count += __builtin_popcountll(toggled[i]);
+				}
+			}
+
+			net_toggles[net] += count;
+		}
+
+		AddToggles(toggled, netlist->GetToggleWeight(net), c);
+	}
+}
+
+// Adds weight to the counter of every pattern that has its bit set in
+// toggled. The weight is added one set bit at a time, each of which is a
+// ripple-carry addition of toggled into the bit-sliced counters.
+__attribute__((always_inline))
+inline void PatternParallel::AddToggles(const word_t &toggled, size_t weight, Counters &c) {
+	for (size_t k = 0; weight; ++k, weight >>= 1) {
+		if (weight & 1) {
+			word_t carry = toggled;
+
+			for (size_t i = k; i < COUNTER_BITS && AnySet(carry); ++i) {
+				const word_t next = c.bits[i] & carry;
+				c.bits[i] ^= carry;
+				carry = next;
+			}
+		}
+	}
+}
+
+// SSE2 is part of x86-64, so it needs no target attribute.
+void PatternParallel::EvaluateSSE2(uint32_t begin, uint32_t end, Counters &c) {
+	EvaluateKernel<KERNEL::SSE2>(begin, end, c);
+}
+
+__attribute__((target("avx2,popcnt")))
+void PatternParallel::EvaluateAVX2(uint32_t begin, uint32_t end, Counters &c) {
+	EvaluateKernel<KERNEL::AVX2>(begin, end, c);
+}
+
+__attribute__((target("avx512f,popcnt")))
+void PatternParallel::EvaluateAVX512(uint32_t begin, uint32_t end, Counters &c) {
+	EvaluateKernel<KERNEL::AVX512>(begin, end, c);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+void PatternParallel::EvaluateAVX512_VPOPCNT(uint32_t begin, uint32_t end, Counters &c) {
+	EvaluateKernel<KERNEL::AVX512_VPOPCNT>(begin, end, c);
+}
+
+void PatternParallel::StepSSE2(Counters &c) {
+	StepKernel<KERNEL::SSE2>(c);
+}
+
+__attribute__((target("avx2,popcnt")))
+void PatternParallel::StepAVX2(Counters &c) {
+	StepKernel<KERNEL::AVX2>(c);
+}
+
+__attribute__((target("avx512f,popcnt")))
+void PatternParallel::StepAVX512(Counters &c) {
+	StepKernel<KERNEL::AVX512>(c);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+void PatternParallel::StepAVX512_VPOPCNT(Counters &c) {
+	StepKernel<KERNEL::AVX512_VPOPCNT>(c);
+}
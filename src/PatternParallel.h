@@ -0,0 +1,120 @@
+#ifndef PATTERNPARALLEL_H
+#define PATTERNPARALLEL_H
+
+#include "main.h"
+
+class PatternParallel {
+public:
+	// One bit per pattern. The kernels operate on the words with whatever
+	// vector width the CPU supports.
+	using word_t = uint64_t __attribute__((vector_size(64)));
+
+	// GCC does not align word_t to its size unless AVX-512 is enabled, but
+	// the AVX2 and AVX-512 kernels load words with aligned loads.
+	static constexpr size_t WORD_ALIGNMENT = 64;
+	template <typename T>
+	struct AlignedAllocator {
+		using value_type = T;
+
+		AlignedAllocator() = default;
+		template <typename U> AlignedAllocator(const AlignedAllocator<U> &) {}
+
+		T *allocate(size_t n) {return static_cast<T *>(::operator new(n * sizeof(T), align_val_t(WORD_ALIGNMENT)));}
+		void deallocate(T *p, size_t) {::operator delete(p, align_val_t(WORD_ALIGNMENT));}
+
+		bool operator ==(const AlignedAllocator &) const {return true;}
+		bool operator !=(const AlignedAllocator &) const {return false;}
+	};
+	using words_t = vector<word_t, AlignedAllocator<word_t>>;
+	static constexpr size_t WORD_SIZE = 64;
+	static constexpr size_t NUM_WORDS = sizeof(word_t) / sizeof(uint64_t);
+	static constexpr size_t NUM_LANES = NUM_WORDS * WORD_SIZE; // Number of patterns per batch.
+
+	enum class KERNEL {SSE2, AVX2, AVX512, AVX512_VPOPCNT};
+
+	void Init(const Netlist &_netlist, const NetState &state);
+	void AddPattern();
+	void AddPattern(const vector<uint8_t> &source_values);
+	void Prime(const NetState &state);
+	void Prime(const PatternParallel &previous);
+	void SetThreadPool(ThreadPool *_pool, const vector<size_t> &level_widths);
+	void SetUnitDelay(bool enable) {unit_delay = enable;}
+	void FillUnusedPatterns();
+	void Evaluate();
+	void MergeToggles(NetState &state);
+	void Clear();
+
+	const bool IsFull() const {return num_patterns == NUM_LANES;}
+	const size_t GetNumPatterns() const {return num_patterns;}
+	const bool GetValue(uint32_t net, size_t pattern) const {
+		return (words[net][pattern / WORD_SIZE] >> (pattern % WORD_SIZE)) & 1;
+	}
+	const bool GetLastValue(uint32_t net) const {return words[net][NUM_WORDS - 1] >> 63;}
+	const size_t GetToggles(size_t pattern) const {return pattern_toggles[pattern];}
+	const size_t GetGlitchToggles(size_t pattern) const {return pattern_glitches[pattern];}
+	const KERNEL GetKernel() const {return kernel;}
+	const string GetKernelName() const;
+	const size_t GetNumParallelLevels() const {return count(parallel_levels.begin(), parallel_levels.end(), 1);}
+private:
+	static constexpr size_t COUNTER_BITS = 48;
+
+	// Levels with fewer gates are not worth waking up the thread pool for.
+	static constexpr size_t MIN_PARALLEL_LEVEL_WIDTH = 1024;
+	static constexpr size_t GATES_PER_TASK = 256;
+
+	// Bit-sliced counters: bit i of bits[k] is bit k of the weighted number
+	// of toggles of pattern i.
+	struct Counters {
+		alignas(WORD_ALIGNMENT) word_t bits[COUNTER_BITS];
+	};
+
+	void EvaluateGates(uint32_t begin, uint32_t end, Counters &counters);
+	void EvaluateSSE2(uint32_t begin, uint32_t end, Counters &counters);
+	void EvaluateAVX2(uint32_t begin, uint32_t end, Counters &counters);
+	void EvaluateAVX512(uint32_t begin, uint32_t end, Counters &counters);
+	void EvaluateAVX512_VPOPCNT(uint32_t begin, uint32_t end, Counters &counters);
+	template <KERNEL K> void EvaluateKernel(uint32_t begin, uint32_t end, Counters &counters);
+	template <KERNEL K> void Commit(uint32_t net, const word_t &value, Counters &counters);
+	template <KERNEL K> void CountToggles(uint32_t net, const word_t &toggled, Counters &counters);
+	void EvaluateUnitDelay();
+	void StepGates(Counters &counters);
+	void StepSSE2(Counters &counters);
+	void StepAVX2(Counters &counters);
+	void StepAVX512(Counters &counters);
+	void StepAVX512_VPOPCNT(Counters &counters);
+	template <KERNEL K> void StepKernel(Counters &counters);
+	void ScheduleFanout(uint32_t net);
+	void ReadCounters(size_t *toggles) const;
+	void AddToggles(const word_t &toggled, size_t weight, Counters &counters);
+
+	const Netlist *netlist = nullptr;
+	KERNEL kernel = KERNEL::SSE2;
+	words_t words; // Value of each net, bit i belongs to pattern i.
+	words_t source_words; // Captured values of the source nets.
+	size_t num_patterns = 0;
+	vector<size_t> net_toggles; // Toggles of each net since the last MergeToggles().
+	vector<uint8_t> prime_values; // Scratch space for Prime().
+
+	// When a thread pool is set, the gates of each level in parallel_levels
+	// are split over its threads, and every thread has its own counters.
+	ThreadPool *pool = nullptr;
+	vector<uint8_t> parallel_levels;
+	vector<Counters> counters = vector<Counters>(1);
+	size_t pattern_toggles[NUM_LANES];
+
+	// With a unit delay, every gate takes one time step, and the patterns
+	// are simulated step by step from the settled values of the pattern
+	// before them. Only the gates that read a net that changed in the
+	// previous step are evaluated.
+	bool unit_delay = false;
+	bool count_net_toggles = true; // False while only the settled values are computed.
+	vector<uint32_t> step_gates; // Gates to evaluate in the current time step.
+	vector<uint32_t> next_step_gates;
+	vector<uint64_t> scheduled_at; // Time step + 1 at which each gate was last scheduled.
+	uint64_t step = 0;
+	words_t step_values; // Outputs of step_gates.
+	words_t initial_words; // Values of the nets before the batch.
+	size_t pattern_glitches[NUM_LANES] = {};
+};
+
+#endif // PATTERNPARALLEL_H
@@ -17,20 +17,7 @@ Radix4BoothDecoder::Radix4BoothDecoder(string _name,
 
 void Radix4BoothDecoder::Update(bool propagating) {
 	if (needs_update || !propagating) {
-		for (size_t i = 0; i < longest_path; ++i) {
-			for (const auto &comp : yj_neg) {
-				comp->Update(propagating);
-			}
-			for (const auto &comp : yj_x1b) {
-				comp->Update(propagating);
-			}
-			for (const auto &comp : yj_m1_z_x2b) {
-				comp->Update(propagating);
-			}
-			for (const auto &comp : ppt_j) {
-				comp->Update(propagating);
-			}
-		}
+		UpdateSubcomponents(propagating, longest_path);
 
 		if (!propagating && print_debug) {
 			PrintDebug();
@@ -40,6 +27,17 @@ void Radix4BoothDecoder::Update(bool propagating) {
 	}
 }
 
+const vector<comp_t> Radix4BoothDecoder::GetSubcomponents() const {
+	vector<comp_t> subcomponents;
+
+	subcomponents.insert(subcomponents.end(), yj_neg.begin(), yj_neg.end());
+	subcomponents.insert(subcomponents.end(), yj_x1b.begin(), yj_x1b.end());
+	subcomponents.insert(subcomponents.end(), yj_m1_z_x2b.begin(), yj_m1_z_x2b.end());
+	subcomponents.insert(subcomponents.end(), ppt_j.begin(), ppt_j.end());
+
+	return subcomponents;
+}
+
 void Radix4BoothDecoder::Connect(PORTS port, const wire_t &wire, size_t index) {
 	CheckIfIndexIsInRange(port, index);
 
@@ -0,0 +1,207 @@
+#include "main.h"
+
+/*
+  Memoization of composite components that are too large for a table.
+
+  The sweep engine only counts the values that the wires are committed to
+  once they have settled, so like an entry of a transition table, the
+  settled values of the wires for a combination of the inputs give exactly
+  the toggles of the gates. Only the wires whose value differs are set.
+
+  Unlike a table, the entries are only filled in when the gates commit a
+  combination, and only if the output of every gate matches its inputs
+  afterwards, so that the wires hold its settled values. Each
+  component keeps at most max_entries combinations, and forgets the one
+  that was used least recently first.
+*/
+
+const size_t ResponseCache::KeyHash::operator ()(const vector<uint64_t> &key) const {
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (const auto &word : key) {
+		hash = (hash ^ word) * 1099511628211ULL;
+		hash ^= hash >> 29;
+	}
+
+	return hash;
+}
+
+// Finds the inputs of a component built from primitive gates, and the
+// wires that they drive. Otherwise the cache is not valid.
+ResponseCache::ResponseCache(const comp_t &component, size_t _max_entries)
+	: max_entries(_max_entries) {
+	vector<comp_t> gates;
+
+	if (component->GetSubcomponents().empty() || !Netlist::CollectGates(component, gates)) {
+		return;
+	}
+
+	unordered_set<const Wire *> driven;
+
+	for (const auto &gate : gates) {
+		const auto &out = gate->GetWire(PORTS::O);
+
+		if (out) {
+			if (!driven.insert(out.get()).second) {
+				return;
+			}
+			wires.push_back(out.get());
+		}
+	}
+
+	unordered_set<const Wire *> seen;
+
+	for (const auto &gate : gates) {
+		const auto [type, ports] = Netlist::IdentifyGate(gate).value();
+
+		for (const auto &port : ports) {
+			const auto &wire = gate->GetWire(port);
+
+			if (!wire || driven.count(wire.get())) {
+				continue;
+			}
+
+			// A wire that is driven by another wire could be driven from
+			// inside the component.
+			if (wire->GetWireInput()) {
+				return;
+			}
+
+			if (seen.insert(wire.get()).second) {
+				inputs.push_back(wire.get());
+			}
+		}
+	}
+
+	// Local net 0 is the constant 0 of unconnected inputs, followed by the
+	// driven wires and then the inputs.
+	unordered_map<const Wire *, uint32_t> local_nets;
+
+	for (size_t w = 0; w < wires.size(); ++w) {
+		local_nets[wires[w]] = 1 + w;
+	}
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		local_nets[inputs[i]] = 1 + wires.size() + i;
+	}
+
+	for (const auto &gate : gates) {
+		const auto &out = gate->GetWire(PORTS::O);
+
+		if (!out) {
+			continue;
+		}
+
+		const auto [type, ports] = Netlist::IdentifyGate(gate).value();
+		LocalGate local{type, {0, 0, 0}, local_nets[out.get()]};
+
+		for (size_t p = 0; p < ports.size(); ++p) {
+			const auto &wire = gate->GetWire(ports[p]);
+			local.in[p] = wire ? local_nets[wire.get()] : 0;
+		}
+
+		local_gates.push_back(local);
+	}
+
+	local_values.resize(1 + wires.size() + inputs.size());
+	key.assign(max((size_t)1, (inputs.size() + 63) / 64), 0);
+	committed.resize(wires.size());
+	for (size_t w = 0; w < wires.size(); ++w) {
+		committed[w] = wires[w]->GetValue();
+	}
+	valid = true;
+}
+
+// Returns true if Apply() can set the wires to the values of the current
+// inputs, and false if the gates have to, after which Store() has to be
+// called. Only the lookups of commits count as hits or misses.
+const bool ResponseCache::Lookup(bool propagating) {
+	fill(key.begin(), key.end(), 0);
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		key[i / 64] |= (uint64_t)inputs[i]->GetValue() << (i % 64);
+	}
+
+	const auto it = index.find(key);
+
+	if (it == index.end()) {
+		found = nullptr;
+		num_misses += !propagating;
+		return false;
+	}
+
+	entries.splice(entries.begin(), entries, it->second);
+	found = &*it->second;
+	num_hits += !propagating;
+	return true;
+}
+
+// Sets the wires to the entry that Lookup() found. While propagating, only
+// the current values of the wires are set. Otherwise the values are
+// committed, which also sets the wires whose current value is not the one
+// that is committed.
+void ResponseCache::Apply(bool propagating) {
+	for (size_t w = 0; w < wires.size(); ++w) {
+		const bool value = (found->values[w / 64] >> (w % 64)) & 1;
+
+		if (propagating) {
+			if (wires[w]->GetValue() != value) {
+				wires[w]->SetValue(value, true);
+			}
+		} else {
+			if (wires[w]->GetValue() != value || committed[w] != value) {
+				wires[w]->SetValue(value, false);
+			}
+			committed[w] = value;
+		}
+	}
+}
+
+// True if the output of every gate matches the values of its inputs, so
+// the wires hold the settled values of the inputs of the component. A
+// subcomponent can still be waiting for an update, but it would not change
+// anything.
+const bool ResponseCache::IsSettled() {
+	for (size_t w = 0; w < wires.size(); ++w) {
+		local_values[1 + w] = wires[w]->GetValue();
+	}
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		local_values[1 + wires.size() + i] = inputs[i]->GetValue();
+	}
+
+	for (const auto &gate : local_gates) {
+		uint8_t value = 0;
+
+		Netlist::Evaluate(gate.type, gate.in.data(), local_values.data(), value);
+		if (value != local_values[gate.out]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Records the values that the gates committed, if they have settled.
+void ResponseCache::Store(bool propagating) {
+	if (propagating) {
+		return;
+	}
+
+	Entry entry{key, vector<uint64_t>(max((size_t)1, (wires.size() + 63) / 64), 0)};
+
+	for (size_t w = 0; w < wires.size(); ++w) {
+		committed[w] = wires[w]->GetValue();
+		entry.values[w / 64] |= (uint64_t)committed[w] << (w % 64);
+	}
+
+	if (!IsSettled()) {
+		num_unsettled++;
+		return;
+	}
+
+	entries.push_front(move(entry));
+	index[entries.front().key] = entries.begin();
+
+	if (entries.size() > max_entries) {
+		index.erase(entries.back().key);
+		entries.pop_back();
+	}
+}
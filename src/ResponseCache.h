@@ -0,0 +1,62 @@
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+
+#include "main.h"
+
+// The settled values of the wires inside a composite component for the most
+// recently used combinations of its inputs, so that a combination that
+// repeats is evaluated without its gates, both while propagating and when
+// the values are committed.
+class ResponseCache {
+public:
+	ResponseCache(const comp_t &component, size_t max_entries);
+
+	const bool Lookup(bool propagating);
+	void Apply(bool propagating);
+	void Store(bool propagating);
+
+	const bool IsValid() const {return valid;}
+	const size_t GetNumEntries() const {return entries.size();}
+	const size_t GetNumHits() const {return num_hits;}
+	const size_t GetNumMisses() const {return num_misses;}
+	const size_t GetNumUnsettled() const {return num_unsettled;}
+private:
+	struct Entry {
+		vector<uint64_t> key; // The values of the inputs.
+		vector<uint64_t> values; // Bit w is the settled value of wires[w].
+	};
+
+	// A gate of the component, with local net 0 as the constant 0 of
+	// unconnected inputs, followed by the driven wires and then the inputs.
+	struct LocalGate {
+		Netlist::GATE type;
+		array<uint32_t, 3> in;
+		uint32_t out;
+	};
+
+	struct KeyHash {
+		const size_t operator ()(const vector<uint64_t> &key) const;
+	};
+
+	const bool IsSettled();
+
+	bool valid = false;
+	size_t max_entries = 0;
+	vector<Wire *> inputs;
+	vector<Wire *> wires; // The wires that the gates of the component drive.
+	vector<LocalGate> local_gates; // Only the gates with a connected output.
+	vector<uint8_t> local_values; // Scratch space for IsSettled().
+
+	list<Entry> entries; // Most recently used first.
+	unordered_map<vector<uint64_t>, list<Entry>::iterator, KeyHash> index;
+
+	vector<uint64_t> key; // The values of the inputs that were looked up last.
+	const Entry *found = nullptr; // The entry that Apply() sets the wires to.
+	vector<uint8_t> committed; // The values that the wires were committed to.
+
+	size_t num_hits = 0;
+	size_t num_misses = 0;
+	size_t num_unsettled = 0; // Commits of the gates after which the wires had not settled.
+};
+
+#endif // RESPONSECACHE_H
@@ -81,10 +81,14 @@ RippleCarryAdder::RippleCarryAdder(string _name, size_t _num_bits)
 
 void RippleCarryAdder::Update(bool propagating) {
 	if (needs_update || !propagating) {
-		for (size_t i = 0; i < longest_path; ++i) {
-			for (auto &fa : full_adders) {
-				fa->Update(propagating);
-			}
+		if (word_level && !propagating && !word_kernel) {
+			word_kernel = make_unique<AdderKernel>(full_adders, true);
+		}
+
+		if (word_level && !propagating && word_kernel->IsExact()) {
+			UpdateBypassingSubcomponents([&]() {word_kernel->Evaluate();});
+		} else {
+			UpdateSubcomponents(propagating, longest_path);
 		}
 
 		if (!propagating && print_debug) {
@@ -95,6 +99,10 @@ void RippleCarryAdder::Update(bool propagating) {
 	}
 }
 
+const vector<comp_t> RippleCarryAdder::GetSubcomponents() const {
+	return vector<comp_t>(full_adders.begin(), full_adders.end());
+}
+
 void RippleCarryAdder::Connect(PORTS port, const wire_t &wire, size_t index) {
 	if (index >= num_bits) {
 		Error("Index " + to_string(index) + " out of bounds for RippleCarryAdder \"" + name + "\".\n");
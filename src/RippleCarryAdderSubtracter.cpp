@@ -67,13 +67,7 @@ RippleCarryAdderSubtracter::RippleCarryAdderSubtracter(string _name, size_t _num
 
 void RippleCarryAdderSubtracter::Update(bool propagating) {
 	if (needs_update || !propagating) {
-		for (size_t i = 0; i < longest_path; ++i) {
-			for (auto &x : xors) {
-				x->Update(propagating);
-			}
-
-			adder->Update(propagating);
-		}
+		UpdateSubcomponents(propagating, longest_path);
 
 		if (!propagating && print_debug) {
 			PrintDebug();
@@ -83,6 +77,13 @@ void RippleCarryAdderSubtracter::Update(bool propagating) {
 	}
 }
 
+const vector<comp_t> RippleCarryAdderSubtracter::GetSubcomponents() const {
+	vector<comp_t> subcomponents(xors.begin(), xors.end());
+	subcomponents.push_back(adder);
+
+	return subcomponents;
+}
+
 void RippleCarryAdderSubtracter::Connect(PORTS port, const wire_t &wire, size_t index) {
 	if (index >= num_bits) {
 		Error("Index " + to_string(index) + " out of bounds for RippleCarryAdderSubtracter \"" + name + "\".\n");
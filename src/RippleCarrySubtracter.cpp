@@ -76,13 +76,7 @@ RippleCarrySubtracter::RippleCarrySubtracter(string _name, size_t _num_bits)
 
 void RippleCarrySubtracter::Update(bool propagating) {
 	if (needs_update || !propagating) {
-		for (size_t i = 0; i < longest_path; ++i) {
-			for (auto &n : nots) {
-				n->Update(propagating);
-			}
-
-			adder->Update(propagating);
-		}
+		UpdateSubcomponents(propagating, longest_path);
 
 		if (!propagating && print_debug) {
 			PrintDebug();
@@ -92,6 +86,13 @@ void RippleCarrySubtracter::Update(bool propagating) {
 	}
 }
 
+const vector<comp_t> RippleCarrySubtracter::GetSubcomponents() const {
+	vector<comp_t> subcomponents(nots.begin(), nots.end());
+	subcomponents.push_back(adder);
+
+	return subcomponents;
+}
+
 void RippleCarrySubtracter::Connect(PORTS port, const wire_t &wire, size_t index) {
 	if (index >= num_bits) {
 		Error("Index " + to_string(index) + " out of bounds for RippleCarrySubtracter \"" + name + "\".\n");
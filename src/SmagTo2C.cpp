@@ -65,20 +65,19 @@ SmagTo2C::SmagTo2C(string _name, size_t _num_bits)
 
 void SmagTo2C::Update(bool propagating) {
 	if (needs_update || !propagating) {
-		for (size_t i = 0; i < longest_path; ++i) {
-			for (const auto &xor_c : xors) {
-				xor_c->Update(propagating);
-			}
-
-			for (const auto &ha : adders) {
-				ha->Update(propagating);
-			}
-		}
+		UpdateSubcomponents(propagating, longest_path);
 
 		needs_update = false;
 	}
 }
 
+const vector<comp_t> SmagTo2C::GetSubcomponents() const {
+	vector<comp_t> subcomponents(xors.begin(), xors.end());
+	subcomponents.insert(subcomponents.end(), adders.begin(), adders.end());
+
+	return subcomponents;
+}
+
 void SmagTo2C::Connect(PORTS port, const wire_t &wire, size_t index) {
 	if (index >= num_bits) {
 		Error("Index " + to_string(index) + " out of bounds for SmagTo2C \"" + name + "\".\n");
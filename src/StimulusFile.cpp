@@ -0,0 +1,188 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstring>
+#include "main.h"
+
+/*
+  Binary stimulus files.
+
+  All numbers are little-endian. The header starts with the 8 bytes of
+  MAGIC, followed by its own size in bytes as a 32-bit number and the number
+  of fields as another one. Each field is described by its width in bits
+  (1 to 64) and the length of its name, one byte each, followed by the name.
+  The header is padded with zeros to its size, which is a multiple of 8.
+
+  The records follow right after the header. Each record holds the value of
+  every field in the order of the header, and each value takes the fewest
+  whole bytes that fit its width, so all records have the same size.
+*/
+
+static const uint32_t ReadUInt32(const uint8_t *bytes) {
+	return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+// Finds the input wire bundle or wire of a field. source names the file or
+// stream in errors.
+const StimulusFile::Field StimulusFile::FindField(const string &name, const System &system, const string &source) {
+	const auto &bundle = system.GetWireBundle(name);
+	const auto &wire = system.GetWire(name);
+	Field field;
+
+	field.name = name;
+	if (bundle && bundle->IsInputBundle()) {
+		field.bundle = bundle;
+		for (const auto &w : bundle->GetWires()) {
+			field.wires.push_back(w.get());
+		}
+	} else if (wire && wire->IsInputWire()) {
+		field.wires.push_back(wire.get());
+	} else {
+		Error("Field \"" + name + "\" of " + source + " is not an input wire bundle or wire.\n");
+	}
+
+	if (field.wires.size() > 64) {
+		Error("Field \"" + name + "\" of " + source + " is wider than 64 bits.\n");
+	}
+
+	field.width = field.wires.size();
+	return field;
+}
+
+// Finds the input wire bundle or wire of each field that a header
+// describes. source names the file or stream in errors.
+const vector<StimulusFile::Field> StimulusFile::ParseHeader(const uint8_t *header, size_t header_size, const System &system, const string &source) {
+	const size_t num_fields = ReadUInt32(header + 12);
+	vector<Field> fields;
+	size_t record_size = 0;
+	size_t pos = 16;
+
+	for (size_t f = 0; f < num_fields; ++f) {
+		if (pos + 2 > header_size || pos + 2 + header[pos + 1] > header_size) {
+			Error("The header of " + source + " is truncated.\n");
+		}
+
+		const size_t width = header[pos];
+		Field field = FindField(string((const char *)header + pos + 2, header[pos + 1]), system, source);
+		pos += 2 + header[pos + 1];
+
+		if (width != field.width) {
+			Error("Field \"" + field.name + "\" of " + source + " is " + to_string(width)
+				  + " bits wide, but it has " + to_string(field.width) + " wires.\n");
+		}
+
+		field.offset = record_size;
+		record_size += (field.width + 7) / 8;
+		fields.push_back(field);
+	}
+
+	return fields;
+}
+
+// Maps the file into memory, and reads its header.
+StimulusFile::StimulusFile(const string &_path, const System &system)
+	: path(_path) {
+	const int fd = open(path.c_str(), O_RDONLY);
+	struct stat st;
+
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		Error("Stimulus file \"" + path + "\" cannot be opened.\n");
+	}
+
+	size = st.st_size;
+	if (size) {
+		void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (mapping == MAP_FAILED) {
+			Error("Stimulus file \"" + path + "\" cannot be mapped into memory.\n");
+		}
+
+		data = (const uint8_t *)mapping;
+		madvise(mapping, size, MADV_SEQUENTIAL);
+	}
+	close(fd);
+
+	if (size < 16 || memcmp(data, MAGIC, sizeof(MAGIC))) {
+		Error("\"" + path + "\" is not a stimulus file.\n");
+	}
+
+	const size_t header_size = ReadUInt32(data + 8);
+
+	if (header_size > size || header_size % 8) {
+		Error("Stimulus file \"" + path + "\" has an invalid header size.\n");
+	}
+
+	fields = ParseHeader(data, header_size, system, "stimulus file \"" + path + "\"");
+	for (const auto &field : fields) {
+		record_size += (field.width + 7) / 8;
+	}
+
+	if (!record_size || (size - header_size) % record_size) {
+		Error("Stimulus file \"" + path + "\" does not end with a whole record.\n");
+	}
+
+	records = data + header_size;
+	num_records = (size - header_size) / record_size;
+}
+
+StimulusFile::~StimulusFile() {
+	if (data) {
+		munmap((void *)data, size);
+	}
+}
+
+// Writes a header with the given names and widths of the fields.
+void StimulusFile::WriteHeader(ostream &output, const vector<pair<string, size_t>> &fields) {
+	string header(MAGIC, sizeof(MAGIC));
+
+	header.append(8, '\0');
+	for (const auto &[name, width] : fields) {
+		header += (char)width;
+		header += (char)name.size();
+		header += name;
+	}
+	header.append((8 - header.size() % 8) % 8, '\0');
+
+	for (size_t i = 0; i < 4; ++i) {
+		header[8 + i] = (char)(header.size() >> (8 * i));
+		header[12 + i] = (char)(fields.size() >> (8 * i));
+	}
+
+	output.write(header.data(), header.size());
+}
+
+const uint64_t StimulusFile::ReadValue(const uint8_t *record, const Field &field) {
+	const uint8_t *bytes = record + field.offset;
+	uint64_t value = 0;
+
+	for (size_t b = 0; b < (field.width + 7) / 8; ++b) {
+		value |= (uint64_t)bytes[b] << (8 * b);
+	}
+
+	return field.width < 64 ? value & ((1ULL << field.width) - 1) : value;
+}
+
+// Sets the wires of a field to the bits of a value, like a stimulus does.
+void StimulusFile::ApplyValue(const Field &field, uint64_t value) {
+	for (size_t i = field.wires.size(); i-- > 0;) {
+		field.wires[i]->SetValue((value >> i) & 1, false);
+	}
+}
+
+void StimulusFile::Apply(size_t record) const {
+	for (size_t f = 0; f < fields.size(); ++f) {
+		ApplyValue(fields[f], GetValue(record, f));
+	}
+}
+
+const uint64_t StimulusFile::GetValue(size_t record, size_t field) const {
+	return ReadValue(records + record * record_size, fields[field]);
+}
+
+// The value of a field in the representation of its wire bundle, converted
+// to two's complement.
+const int64_t StimulusFile::Get2CValue(size_t record, size_t field) const {
+	const int64_t value = GetValue(record, field);
+	return fields[field].bundle ? fields[field].bundle->To2CValue(value) : value;
+}
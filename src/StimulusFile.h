@@ -0,0 +1,51 @@
+#ifndef STIMULUSFILE_H
+#define STIMULUSFILE_H
+
+#include "main.h"
+
+// Stimuli in a binary file: a header with the name and width of each input
+// wire bundle or wire, followed by records of a fixed size that hold one
+// value for each of them. The file is mapped into memory, so the records
+// are read where they are instead of being copied, and record i can be
+// found without reading the ones before it.
+class StimulusFile {
+public:
+	static constexpr char MAGIC[8] = {'B', 'F', 'S', 'T', 'I', 'M', '0', '1'};
+
+	// A value in every record. A wire is a field of width 1.
+	struct Field {
+		string name;
+		size_t width = 0; // In bits.
+		size_t offset = 0; // In bytes, from the beginning of a record.
+		wb_t bundle = nullptr; // Not set for a single wire.
+		vector<Wire *> wires; // Bit i of the value is applied to wires[i].
+	};
+
+	static const Field FindField(const string &name, const System &system, const string &source);
+	static const vector<Field> ParseHeader(const uint8_t *header, size_t header_size, const System &system, const string &source);
+	static const uint64_t ReadValue(const uint8_t *record, const Field &field);
+	static void ApplyValue(const Field &field, uint64_t value);
+	static void WriteHeader(ostream &output, const vector<pair<string, size_t>> &fields);
+
+	StimulusFile(const string &path, const System &system);
+	~StimulusFile();
+	StimulusFile(const StimulusFile &) = delete;
+	StimulusFile &operator =(const StimulusFile &) = delete;
+
+	void Apply(size_t record) const;
+
+	const uint64_t GetValue(size_t record, size_t field) const;
+	const int64_t Get2CValue(size_t record, size_t field) const;
+	const size_t GetNumRecords() const {return num_records;}
+	const vector<Field> &GetFields() const {return fields;}
+private:
+	string path;
+	const uint8_t *data = nullptr; // The whole file.
+	size_t size = 0;
+	const uint8_t *records = nullptr;
+	size_t record_size = 0;
+	size_t num_records = 0;
+	vector<Field> fields;
+};
+
+#endif // STIMULUSFILE_H
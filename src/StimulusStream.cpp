@@ -0,0 +1,245 @@
+#include <sstream>
+#include "main.h"
+
+// Reads the header of the stream. A stream that does not start with the
+// header of the binary format is text.
+StimulusStream::StimulusStream(istream &_input, const System &system)
+	: input(_input) {
+	const string source = "the stimulus stream";
+	char magic[sizeof(StimulusFile::MAGIC)];
+
+	input.read(magic, sizeof(magic));
+	binary = input.gcount() == sizeof(magic) && equal(magic, magic + sizeof(magic), StimulusFile::MAGIC);
+
+	if (binary) {
+		vector<uint8_t> header(16);
+
+		copy(magic, magic + sizeof(magic), header.begin());
+		if (!input.read((char *)header.data() + sizeof(magic), 8)) {
+			Error("The header of " + source + " is truncated.\n");
+		}
+
+		size_t header_size = 0;
+		for (size_t i = 0; i < 4; ++i) {
+			header_size |= (size_t)header[8 + i] << (8 * i);
+		}
+
+		if (header_size < 16 || header_size % 8) {
+			Error("The stimulus stream has an invalid header size.\n");
+		}
+
+		header.resize(header_size);
+		if (!input.read((char *)header.data() + 16, header_size - 16)) {
+			Error("The header of " + source + " is truncated.\n");
+		}
+
+		fields = StimulusFile::ParseHeader(header.data(), header_size, system, source);
+		for (const auto &field : fields) {
+			record_size += (field.width + 7) / 8;
+		}
+
+		if (!record_size) {
+			Error("The stimulus stream has no fields.\n");
+		}
+	} else {
+		pending.assign(magic, input.gcount());
+		input.clear();
+
+		string line;
+		string name;
+
+		// The first line that is not empty names the fields.
+		while (ReadLine(line) && line.find_first_not_of(" \t\r") == string::npos) {
+		}
+
+		istringstream names(line);
+		while (names >> name) {
+			fields.push_back(StimulusFile::FindField(name, system, source));
+		}
+
+		if (fields.empty()) {
+			Error("The stimulus stream has no fields.\n");
+		}
+	}
+
+	output_bundles = system.GetOutputWireBundles();
+	output_wires = system.GetOutputWires();
+}
+
+// Reads the next line of text, starting with the text that was read
+// before the format was known.
+const bool StimulusStream::ReadLine(string &line) {
+	if (pending.empty()) {
+		return (bool)getline(input, line);
+	}
+
+	const size_t end = pending.find('\n');
+
+	if (end != string::npos) {
+		line = pending.substr(0, end);
+		pending.erase(0, end + 1);
+		return true;
+	}
+
+	string rest;
+
+	line = pending;
+	pending.clear();
+	if (getline(input, rest)) {
+		line += rest;
+	}
+
+	return true;
+}
+
+// A value is given like in the stimuli section, or as a decimal number.
+// It is converted to the bits of the representation of its wire bundle.
+const uint64_t StimulusStream::ParseValue(const string &token, const StimulusFile::Field &field) const {
+	string digits = token;
+	int base = 10;
+
+	if (digits.length() > 2 && digits[0] == '0') {
+		switch (digits[1]) {
+		case 'b': case 'B': base = 2; break;
+		case 'x': case 'X': base = 16; break;
+		case 'd': case 'D': base = 10; break;
+		default: break;
+		}
+
+		if (isalpha(digits[1])) {
+			digits.erase(0, 2);
+		}
+	}
+
+	int64_t value = 0;
+	size_t end = 0;
+
+	try {
+		value = stoll(digits, &end, base);
+	} catch (invalid_argument e) {
+	} catch (out_of_range e) {
+	}
+
+	if (!end || end != digits.length()) {
+		Error("Value \"" + token + "\" of field \"" + field.name + "\" in the stimulus stream is invalid.\n");
+	}
+
+	if (field.bundle) {
+		value = field.bundle->From2CValue(value);
+	}
+
+	return field.width < 64 ? (uint64_t)value & ((1ULL << field.width) - 1) : value;
+}
+
+// Reads up to max_records records, and returns how many were read. Only
+// returns less once the stream has ended.
+const size_t StimulusStream::Read(size_t max_records) {
+	size_t num_records = 0;
+
+	values.clear();
+
+	if (binary) {
+		buffer.resize(max_records * record_size);
+		input.read((char *)buffer.data(), buffer.size());
+
+		const size_t num_bytes = input.gcount();
+		if (num_bytes % record_size) {
+			Error("The stimulus stream does not end with a whole record.\n");
+		}
+
+		num_records = num_bytes / record_size;
+		for (size_t r = 0; r < num_records; ++r) {
+			for (const auto &field : fields) {
+				values.push_back(StimulusFile::ReadValue(buffer.data() + r * record_size, field));
+			}
+		}
+
+		return num_records;
+	}
+
+	string line;
+	string token;
+
+	while (num_records < max_records && ReadLine(line)) {
+		istringstream tokens(line);
+		size_t f = 0;
+
+		while (tokens >> token) {
+			if (f == fields.size()) {
+				Error("A record of the stimulus stream has more than " + to_string(fields.size()) + " values.\n");
+			}
+			values.push_back(ParseValue(token, fields[f++]));
+		}
+
+		// Empty lines are skipped.
+		if (f == 0) {
+			continue;
+		} else if (f < fields.size()) {
+			Error("A record of the stimulus stream has fewer than " + to_string(fields.size()) + " values.\n");
+		}
+
+		num_records++;
+	}
+
+	return num_records;
+}
+
+// Sets the input wires to the values of a record of the current batch.
+void StimulusStream::Apply(size_t record) const {
+	for (size_t f = 0; f < fields.size(); ++f) {
+		StimulusFile::ApplyValue(fields[f], values[record * fields.size() + f]);
+	}
+}
+
+// The results have a field for the toggles, followed by one for each output
+// wire bundle and wire.
+void StimulusStream::WriteHeader(ostream &output) const {
+	vector<pair<string, size_t>> result_fields = {{"toggles", 64}};
+
+	for (const auto &bundle : output_bundles) {
+		result_fields.emplace_back(bundle->GetName(), bundle->GetSize());
+	}
+	for (const auto &wire : output_wires) {
+		result_fields.emplace_back(wire->GetName(), 1);
+	}
+
+	if (binary) {
+		StimulusFile::WriteHeader(output, result_fields);
+		return;
+	}
+
+	for (size_t i = 0; i < result_fields.size(); ++i) {
+		output << (i ? " " : "") << result_fields[i].first;
+	}
+	output << '\n';
+}
+
+// Writes the toggles of a record and the values of the outputs after it.
+// The text format has the values in two's complement.
+void StimulusStream::WriteResult(ostream &output, size_t toggles) const {
+	if (!binary) {
+		output << toggles;
+		for (const auto &bundle : output_bundles) {
+			output << ' ' << bundle->Get2CValue();
+		}
+		for (const auto &wire : output_wires) {
+			output << ' ' << wire->GetValue();
+		}
+		output << '\n';
+		return;
+	}
+
+	auto write = [&](uint64_t value, size_t width) {
+		for (size_t b = 0; b < (width + 7) / 8; ++b) {
+			output.put((char)(value >> (8 * b)));
+		}
+	};
+
+	write(toggles, 64);
+	for (const auto &bundle : output_bundles) {
+		write(bundle->GetValue(), bundle->GetSize());
+	}
+	for (const auto &wire : output_wires) {
+		write(wire->GetValue(), 1);
+	}
+}
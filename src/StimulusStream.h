@@ -0,0 +1,40 @@
+#ifndef STIMULUSSTREAM_H
+#define STIMULUSSTREAM_H
+
+#include "main.h"
+
+// Stimuli that are read from a stream, like stdin or a named pipe, one
+// batch of records at a time, so that a stream of any length is simulated
+// with the same memory. The stream is either in the binary format of a
+// StimulusFile, or text: a line with the names of the input wire bundles
+// or wires, followed by a line with their values for every record.
+//
+// The results of each record are written in the same format: the toggles
+// of the record, followed by the values of the outputs.
+class StimulusStream {
+public:
+	StimulusStream(istream &_input, const System &system);
+
+	const size_t Read(size_t max_records);
+	void Apply(size_t record) const;
+	void WriteHeader(ostream &output) const;
+	void WriteResult(ostream &output, size_t toggles) const;
+
+	const bool IsBinary() const {return binary;}
+private:
+	const bool ReadLine(string &line);
+	const uint64_t ParseValue(const string &token, const StimulusFile::Field &field) const;
+
+	istream &input;
+	bool binary = false;
+	string pending; // Text that was read while looking for the header of the binary format.
+	vector<StimulusFile::Field> fields;
+	size_t record_size = 0; // Only used by the binary format.
+	vector<uint8_t> buffer; // The records of the current batch in the binary format.
+	vector<uint64_t> values; // The value of every field of every record of the current batch.
+
+	vector<wb_t> output_bundles;
+	vector<wire_t> output_wires;
+};
+
+#endif // STIMULUSSTREAM_H
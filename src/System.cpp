@@ -1,3 +1,7 @@
+#include <cxxabi.h>
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
 #include "main.h"
 
 void System::AddComponent(comp_t component) {
@@ -9,7 +13,9 @@ void System::AddComponent(comp_t component) {
 			cout << "[Warning] Component \"" << component->GetName()
 				 << "\" has one or more ports that are not connected.\n";
 		} else {
-			wires.insert(pair<string, wire_t>(w->GetName(), w));
+			if (wires.insert(pair<string, wire_t>(w->GetName(), w)).second) {
+				w->SetToggleCounter(&wire_toggles);
+			}
 
 			const auto &wb = w->GetWireBundle();
 			if (wb) {
@@ -167,64 +173,886 @@ void System::AddWireBundle(wb_t wb) {
 //	}
 }
 
+// Lets every component that can evaluate its subcomponents with word-level
+// operations do so, including the ones inside composite components.
+void System::SetWordLevel(bool enable) {
+	function<void(const comp_t &)> set_word_level = [&](const comp_t &component) {
+		component->SetWordLevel(enable);
+
+		for (const auto &c : component->GetSubcomponents()) {
+			set_word_level(c);
+		}
+	};
+
+	for (const auto &[name, component] : components) {
+		if (component) {
+			set_word_level(component);
+		}
+	}
+}
+
+// Gives every composite component with at most max_entries combinations of
+// its inputs a transition table, so that it is evaluated with a lookup.
+// The components inside a component with a table are no longer updated,
+// so they do not get one.
+void System::BuildTransitionTables(size_t max_entries) {
+	size_t num_tables = 0;
+	size_t num_cached = 0;
+	unordered_set<const vector<uint64_t> *> distinct_tables;
+
+	function<void(const comp_t &)> build = [&](const comp_t &component) {
+		const auto subcomponents = component->GetSubcomponents();
+		if (subcomponents.empty()) {
+			return;
+		}
+
+		auto table = make_unique<TransitionTable>(component, max_entries);
+
+		if (table->IsValid()) {
+			num_tables++;
+			num_cached += table->IsCached();
+			distinct_tables.insert(table->GetEntries());
+			component->SetTransitionTable(move(table));
+			return;
+		}
+
+		for (const auto &c : subcomponents) {
+			if (c) {
+				build(c);
+			}
+		}
+	};
+
+	for (const auto &[name, component] : components) {
+		if (component) {
+			build(component);
+		}
+	}
+
+	cout << "Transition tables: " << num_tables << " components, "
+		 << distinct_tables.size() << " distinct, "
+		 << num_cached << " read from the cache\n";
+}
+
+// The name of the class of a component, which is also its type in the
+// configuration for the ones that can be used there.
+static const string GetTypeName(const Component &component) {
+	const char *mangled = typeid(component).name();
+	int status = 0;
+	char *demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+	const string name = status == 0 ? demangled : mangled;
+
+	free(demangled);
+	return name;
+}
+
+// Gives every composite component of the given types, or of all types if
+// none are given, a response cache that keeps max_entries transitions.
+// Components inside a component with a cache are only updated when it
+// misses, so they do not get one. Neither do components with a transition
+// table inside, since a hit would bypass the table, but the components
+// inside them can get one.
+void System::BuildResponseCaches(size_t max_entries, const vector<string> &types) {
+	size_t num_caches = 0;
+
+	function<bool(const comp_t &)> has_table = [&](const comp_t &component) {
+		if (component->HasTransitionTable()) {
+			return true;
+		}
+
+		for (const auto &c : component->GetSubcomponents()) {
+			if (c && has_table(c)) {
+				return true;
+			}
+		}
+
+		return false;
+	};
+
+	function<void(const comp_t &)> build = [&](const comp_t &component) {
+		const auto subcomponents = component->GetSubcomponents();
+		if (subcomponents.empty() || component->HasTransitionTable()) {
+			return;
+		}
+
+		const string type = GetTypeName(*component);
+
+		if ((types.empty() || find(types.begin(), types.end(), type) != types.end()) && !has_table(component)) {
+			auto cache = make_unique<ResponseCache>(component, max_entries);
+
+			if (cache->IsValid()) {
+				num_caches++;
+				response_caches[type].push_back(cache.get());
+				component->SetResponseCache(move(cache));
+				return;
+			}
+		}
+
+		for (const auto &c : subcomponents) {
+			if (c) {
+				build(c);
+			}
+		}
+	};
+
+	for (const auto &[name, component] : components) {
+		if (component) {
+			build(component);
+		}
+	}
+
+	cout << "Response caches: " << num_caches << " components\n";
+}
+
+// Indexes all wires and components, and lets the arena take over the
+// connections of the wires. Call this once the system is complete. The
+// worklists of the components are created first, so that they end up next
+// to each other instead of in the gaps that the connections leave behind.
+void System::BuildArena() {
+	for (const auto &[name, component] : components) {
+		if (component) {
+			component->InitWorklist();
+		}
+	}
+
+	arena->Build(wires);
+}
+
+// Finds the largest number of components on any path from the global input
+// wires, in a single topological pass over the components they reach. The
+// depth of a component is the number of components on the longest path to
+// it, including itself.
 void System::FindLongestPathInSystem() {
-	// Start with the global input wires.
-	vector<wire_t> wires_to_process(all_input_wires);
-	vector<comp_t> components_to_process;
+	unordered_map<const Component *, size_t> index;
+	vector<const Component *> reached;
+	vector<vector<size_t>> fanouts;
 
 	cout << "Finding longest path in the system.\n";
 
-	do {
-		components_to_process.clear();
+	auto reach = [&](const Component *component) {
+		const auto [it, added] = index.emplace(component, reached.size());
 
-		// Find all the components that the wires to be processed are connected to.
-		for (const auto &w : wires_to_process) {
-			for (const auto &c : w->GetComponentOutputs()) {
-				const auto comp = c.lock();
+		if (added) {
+			reached.push_back(component);
+			fanouts.emplace_back();
+		}
+		return it->second;
+	};
 
-				if (find(components_to_process.begin(),
-						 components_to_process.end(),
-						 comp) == components_to_process.end()) {
-					components_to_process.push_back(comp);
-				}
+	// Components that read a global input wire start a path.
+	for (const auto &w : all_input_wires) {
+		for (const auto &c : w->GetComponentOutputs()) {
+			reach(c);
+		}
+	}
+
+	for (size_t i = 0; i < reached.size(); ++i) {
+		for (const auto &w : reached[i]->GetOutputWires()) {
+			if (!w) {
+				continue;
+			}
+
+			for (const auto &c : w->GetComponentOutputs()) {
+				const size_t f = reach(c);
+				fanouts[i].push_back(f);
 			}
 		}
+	}
 
-		if (!components_to_process.empty()) {
-			longest_path++;
+	vector<size_t> num_pending(reached.size(), 0);
+	for (const auto &fanout : fanouts) {
+		for (const auto &f : fanout) {
+			num_pending[f]++;
 		}
+	}
 
-		// Populate the list of wires to be processed with the outputs of
-		// the components to process.
-		wires_to_process.clear();
+	vector<size_t> depths(reached.size(), 1);
+	vector<size_t> ready;
 
-		for (const auto &c : components_to_process) {
-			for (const auto &w : c->GetOutputWires()) {
-				if (find(wires_to_process.begin(),
-						 wires_to_process.end(),
-						 w) == wires_to_process.end()) {
-					wires_to_process.push_back(w);
-				}
+	for (size_t i = 0; i < reached.size(); ++i) {
+		if (num_pending[i] == 0) {
+			ready.push_back(i);
+		}
+	}
+
+	for (size_t r = 0; r < ready.size(); ++r) {
+		const size_t i = ready[r];
+		longest_path = max(longest_path, depths[i]);
+
+		for (const auto &f : fanouts[i]) {
+			depths[f] = max(depths[f], depths[i] + 1);
+
+			if (--num_pending[f] == 0) {
+				ready.push_back(f);
 			}
 		}
-	} while (!components_to_process.empty());
+	}
+
+	if (ready.size() != reached.size()) {
+		Error("Combinational loop detected, so the longest path cannot be found.\n");
+	}
 
 	assert(longest_path != 0);
 }
 
 // Finds the initial state which is the state of the system
 // when all inputs are 0.
-void System::FindInitialState() {
-	for (size_t i = 0; i < longest_path; ++i) {
-		for (const auto &[name, component] : components) {
-			if (component) {
-				component->Update(false);
+// Commits every gate once in level order, starting from all wires at 0.
+// All inputs of a gate have settled by the time it is committed, so each
+// wire only toggles once, from 0 to its settled value. Call this after
+// Levelize().
+//
+// With use_cache, the settled values are kept in the cache directory,
+// keyed on the gates and how they are connected, so the next run of the
+// same system commits them without evaluating the gates. Without a usable
+// cache directory, they are found as if use_cache was not set.
+void System::FindInitialState(bool use_cache) {
+	string problem;
+	const auto cache_path = use_cache ? FindCacheDirectory(problem) : nullopt;
+
+	if (use_cache && !cache_path) {
+		cout << "[Warning] " << problem << "The initial state is not cached.\n";
+	}
+
+	if (!cache_path) {
+		for (const auto &gate : levelized_gates) {
+			gate->Update(false);
+		}
+
+		cout << "Initial state: found in one pass\n";
+		return;
+	}
+
+	unordered_map<const Wire *, size_t> wire_index;
+	string description;
+
+	auto add_wire = [&](const wire_t &wire) {
+		if (!wire) {
+			description += " -";
+			return;
+		}
+
+		const auto [it, inserted] = wire_index.emplace(wire.get(), wire_index.size());
+		description += ' ' + to_string(it->second);
+	};
+
+	for (const auto &gate : levelized_gates) {
+		const auto primitive = Netlist::IdentifyGate(gate);
+
+		if (!primitive) {
+			Error("Component \"" + gate->GetName() + "\" is not a primitive gate, so the initial state cannot be found.\n");
+		}
+
+		description += to_string((int)primitive->first);
+		for (const auto &port : primitive->second) {
+			add_wire(gate->GetWire(port));
+		}
+		add_wire(gate->GetWire(PORTS::O));
+		description += '\n';
+	}
+
+	stringstream name;
+	name << hex << setw(16) << setfill('0') << Hash(description);
+
+	const string state_path = (std::filesystem::path(cache_path.value()) / (name.str() + ".state")).string();
+	vector<uint64_t> values;
+	const bool cached = ReadCacheFile(state_path, description, (levelized_gates.size() + 63) / 64, values);
+
+	if (!cached) {
+		values.assign((levelized_gates.size() + 63) / 64, 0);
+	}
+
+	for (size_t g = 0; g < levelized_gates.size(); ++g) {
+		const auto &gate = levelized_gates[g];
+		const auto &out = gate->GetWire(PORTS::O);
+
+		if (cached) {
+			if (out) {
+				out->SetValue((values[g / 64] >> (g % 64)) & 1, false);
+			}
+			gate->Reset();
+		} else {
+			gate->Update(false);
+			if (out && out->GetValue()) {
+				values[g / 64] |= 1ULL << (g % 64);
 			}
 		}
 	}
+
+	if (!cached) {
+		WriteCacheFile(state_path, description, values);
+	}
+
+	cout << "Initial state: " << (cached ? "read from the cache" : "found in one pass") << '\n';
 }
 
+// Collects every primitive gate in the system, including the ones hidden
+// inside composite components, and sorts them by topological level. Only
+// primitive gates drive or are driven by wires, so walking the wires is
+// enough to find all of them.
+void System::Levelize() {
+	vector<comp_t> gates;
+	unordered_map<const Component *, size_t> gate_index;
+	unordered_set<const Wire *> visited_wires;
+	vector<wire_t> wires_to_process;
+
+	cout << "Levelizing the system.\n";
+
+	auto add_gate = [&](Component *gate) {
+		if (gate && gate_index.find(gate) == gate_index.end()) {
+			gate_index[gate] = gates.size();
+			gates.push_back(gate->shared_from_this());
+		}
+	};
+
+	auto add_wire = [&](const wire_t &wire) {
+		if (wire && visited_wires.insert(wire.get()).second) {
+			wires_to_process.push_back(wire);
+		}
+	};
+
+	for (const auto &[name, wire] : wires) {
+		add_wire(wire);
+	}
+
+	size_t gate_idx = 0;
+	while (!wires_to_process.empty() || gate_idx < gates.size()) {
+		while (!wires_to_process.empty()) {
+			const auto w = wires_to_process.back();
+			wires_to_process.pop_back();
+
+			add_gate(w->GetComponentInput());
+			for (const auto &c : w->GetComponentOutputs()) {
+				add_gate(c);
+			}
+		}
+
+		for (; gate_idx < gates.size(); ++gate_idx) {
+			for (const auto &w : gates[gate_idx]->GetInputWires()) {
+				add_wire(w);
+			}
+			for (const auto &w : gates[gate_idx]->GetOutputWires()) {
+				add_wire(w);
+			}
+		}
+	}
+
+	// Kahn's algorithm: a gate is ready once all gates driving its inputs
+	// have been assigned a level.
+	const size_t num_gates = gates.size();
+	vector<size_t> num_pending(num_gates, 0);
+	vector<size_t> levels(num_gates, 1);
+	vector<vector<size_t>> fanouts(num_gates);
+
+	for (size_t i = 0; i < num_gates; ++i) {
+		for (const auto &w : gates[i]->GetInputWires()) {
+			if (w) {
+				const auto driver = w->GetComponentInput();
+				if (driver) {
+					fanouts[gate_index[driver]].push_back(i);
+					num_pending[i]++;
+				}
+			}
+		}
+	}
+
+	vector<size_t> ready;
+	ready.reserve(num_gates);
+	for (size_t i = 0; i < num_gates; ++i) {
+		if (num_pending[i] == 0) {
+			ready.push_back(i);
+		}
+	}
+
+	num_levels = 0;
+	for (size_t r = 0; r < ready.size(); ++r) {
+		const size_t g = ready[r];
+		num_levels = max(num_levels, levels[g]);
+
+		for (const auto &f : fanouts[g]) {
+			levels[f] = max(levels[f], levels[g] + 1);
+
+			if (--num_pending[f] == 0) {
+				ready.push_back(f);
+			}
+		}
+	}
+
+	if (ready.size() != num_gates) {
+		Error("Combinational loop detected, so the system cannot be levelized.\n");
+	}
+
+	// Sort the gates by level, keeping the discovery order within a level.
+	vector<vector<comp_t>> gates_per_level(num_levels + 1);
+	for (size_t i = 0; i < num_gates; ++i) {
+		gates[i]->SetLevel(levels[i]);
+		gates_per_level[levels[i]].push_back(gates[i]);
+	}
+
+	levelized_gates.clear();
+	levelized_gates.reserve(num_gates);
+	level_widths.clear();
+	for (const auto &level : gates_per_level) {
+		levelized_gates.insert(levelized_gates.end(), level.begin(), level.end());
+		level_widths.push_back(level.size());
+	}
+
+	cout << "Number of gates: " << num_gates << "\nNumber of levels: " << num_levels << '\n';
+	if (num_levels > 0) {
+		cout << "Widest level: " << *max_element(level_widths.begin(), level_widths.end())
+			 << " gates\nAverage level width: " << num_gates / num_levels << " gates\n";
+	}
+}
+
+// Flattens the levelized gates into a netlist, and takes the current
+// values of the wires as its initial state. Call this after the initial
+// state has been found.
+void System::Elaborate() {
+	full_netlist = make_shared<Netlist>();
+	full_netlist->Elaborate(*this);
+	netlist = full_netlist;
+	netlist->InitState(net_state);
+
+	// From now on the netlist counts the toggles of the wires it drives,
+	// starting from what they counted while finding the initial state.
+	for (const auto &[name, wire] : wires) {
+		if (wire && netlist->IsGateOutput(wire)) {
+			net_state.num_toggles += wire->GetNumToggles();
+			wire->SetToggleCounter(nullptr);
+		}
+	}
+
+	InitEngine();
+
+	cout << "Number of nets: " << netlist->GetNumNets() << '\n';
+	cout << "Removed gates: " << netlist->GetNumConstantGates() << " constant, "
+		 << netlist->GetNumDeadGates() << " unobserved, "
+		 << netlist->GetNumGates() << " left\n";
+	if (engine == ENGINE::PARALLEL || engine == ENGINE::TIMED_PARALLEL) {
+		cout << "Kernel: " << batches[0].GetKernelName()
+			 << "\nNumber of threads: " << num_threads << '\n';
+
+		if (split == SPLIT::LEVELS) {
+			cout << "Parallel levels: " << batches[0].GetNumParallelLevels() << " of " << num_levels << '\n';
+		}
+	} else if (engine == ENGINE::COMPILED) {
+		cout << "Compiled netlist: " << compiled_netlist.GetLibraryPath()
+			 << (compiled_netlist.IsCached() ? " (cached)" : "") << '\n';
+	} else if (engine == ENGINE::TIMED) {
+		cout << "Largest gate delay: " << timing_wheel.GetMaxDelay() << '\n';
+	}
+}
+
+// Prepares the engine for the current netlist. The engines keep their
+// counters, so the netlist can be swapped between updates.
+void System::InitEngine() {
+	// Removed gates no longer take up room in their level.
+	for (size_t l = 0; l < level_widths.size(); ++l) {
+		level_widths[l] = netlist->GetLevelEnd(l) - netlist->GetLevelBegin(l);
+	}
+
+	if (engine == ENGINE::LEVELIZED) {
+		netlist->InitCommitted(net_state);
+	} else if (engine == ENGINE::EVENT) {
+		event_queue.Init(*netlist);
+	} else if (engine == ENGINE::PARALLEL || engine == ENGINE::TIMED_PARALLEL) {
+		// Either every thread simulates its own batch of patterns, or all
+		// threads work on the wide levels of a single batch.
+		batches.resize(split == SPLIT::TIME ? num_threads : 1);
+		batch_snapshots.assign(batches.size(), nullptr);
+		for (auto &batch : batches) {
+			batch.Init(*netlist, net_state);
+			batch.SetUnitDelay(engine == ENGINE::TIMED_PARALLEL);
+		}
+		current_batch = 0;
+
+		if (split == SPLIT::LEVELS) {
+			if (!thread_pool) {
+				thread_pool = make_unique<ThreadPool>(num_threads);
+			}
+			batches[0].SetThreadPool(thread_pool.get(), level_widths);
+		}
+	} else if (engine == ENGINE::COMPILED) {
+		compiled_netlist.Init(*netlist);
+		netlist->InitCommitted(net_state);
+	} else if (engine == ENGINE::TIMED) {
+		timing_wheel.Init(*netlist, net_state, gate_delays);
+	}
+}
+
+// Switches the engine to another netlist over the same nets. All updates
+// have to be flushed before.
+void System::UseNetlist(const shared_ptr<Netlist> &_netlist) {
+	netlist = _netlist;
+	InitEngine();
+}
+
+// Holds the given wires at the values the stimuli give them, until this
+// is called again. The netlist is then specialized for their values, and
+// specialized again whenever one of them changes. Wires that do not feed
+// any gate are ignored, and so are all wires with the sweep engine, which
+// does not use the netlist, and the compiled engine, which would have to
+// compile every specialized netlist.
+void System::HoldWires(const vector<wire_t> &held_wires) {
+	if (!netlist || engine == ENGINE::SWEEP || engine == ENGINE::COMPILED) {
+		return;
+	}
+
+	vector<uint32_t> nets;
+	for (const auto &wire : held_wires) {
+		const auto net = netlist->GetNet(wire);
+
+		if (net && !netlist->IsGateOutput(wire)) {
+			nets.push_back(net.value());
+		}
+	}
+
+	if (nets == held_nets) {
+		return;
+	}
+
+	Flush();
+	if (netlist != full_netlist) {
+		UseNetlist(full_netlist);
+	}
+	held_nets = nets;
+	held_values.clear();
+}
+
+// True if the netlist has to be specialized for the current values of
+// the held wires.
+const bool System::HeldValuesChanged() const {
+	if (held_nets.empty()) {
+		return false;
+	} else if (held_values.empty()) {
+		return true;
+	}
+
+	for (size_t i = 0; i < held_nets.size(); ++i) {
+		if (netlist->GetNetWire(held_nets[i])->GetValue() != held_values[i]) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Specializes the full netlist for the values the held nets have in the
+// state.
+void System::Specialize() {
+	held_values.clear();
+	for (const auto &net : held_nets) {
+		held_values.push_back(net_state.values[net]);
+	}
+
+	auto residual = make_shared<Netlist>();
+	residual->Specialize(*full_netlist, held_nets, net_state);
+	UseNetlist(residual);
+	num_specializations++;
+}
+
+// Simulates the current values of the inputs. The results are available
+// once the commit handler is called, which is right away for all engines
+// except the pattern-parallel ones.
 void System::Update() {
+	// The update in which a held wire changes is simulated with the full
+	// netlist, so that every net has settled to the new held values before
+	// the netlist is specialized for them.
+	const bool specialize = HeldValuesChanged();
+	if (specialize && netlist != full_netlist) {
+		Flush();
+		UseNetlist(full_netlist);
+	}
+
+	switch (engine) {
+	case ENGINE::SWEEP:     UpdateSweep(); break;
+	case ENGINE::LEVELIZED: UpdateLevelized(); break;
+	case ENGINE::EVENT:     UpdateEvent(); break;
+	case ENGINE::PARALLEL:  UpdateParallel(); break;
+	case ENGINE::COMPILED:  UpdateCompiled(); break;
+	case ENGINE::TIMED:     UpdateTimed(); break;
+	case ENGINE::TIMED_PARALLEL: UpdateParallel(); break;
+	}
+
+	// The pattern-parallel engines call it once the batch is simulated.
+	if (commit_handler && engine != ENGINE::PARALLEL && engine != ENGINE::TIMED_PARALLEL) {
+		commit_handler();
+	}
+
+	if (specialize) {
+		Flush();
+		Specialize();
+	}
+}
+
+// Simulates all updates that are still pending, and calls the commit
+// handler for each of them in order.
+void System::Flush() {
+	if ((engine == ENGINE::PARALLEL || engine == ENGINE::TIMED_PARALLEL) && batch_wire_toggles.size()) {
+		Commit();
+	}
+}
+
+// Simulates every record of a stimulus file as an update of its own, as if
+// it was applied to the input wires before the update. The handler is
+// called before each record is simulated. The pattern-parallel engines do
+// not apply every record to the wires: each batch captures its own part of
+// the records straight from the file in its own thread, and the wires only
+// take the values of the last record.
+void System::UpdateFromFile(const StimulusFile &file, const function<void(size_t)> &handler) {
+	const size_t num_records = file.GetNumRecords();
+
+	// The held wires have to be checked for every update.
+	if ((engine != ENGINE::PARALLEL && engine != ENGINE::TIMED_PARALLEL) || held_nets.size()) {
+		for (size_t r = 0; r < num_records; ++r) {
+			handler(r);
+			file.Apply(r);
+			Update();
+		}
+		return;
+	}
+
+	Flush();
+
+	const auto &fields = file.GetFields();
+	const auto &sources = netlist->GetSourceNets();
+	constexpr size_t NUM_LANES = PatternParallel::NUM_LANES;
+	constexpr size_t NO_FIELD = SIZE_MAX;
+
+	// A bit of the value of a field.
+	struct FieldBit {
+		size_t field = NO_FIELD;
+		size_t bit = 0;
+	};
+
+	unordered_map<const Wire *, FieldBit> field_bits;
+	vector<size_t> bit_offsets;
+	vector<uint64_t> initial_values(fields.size(), 0); // The values of the fields before the first record.
+	size_t num_bits = 0;
+
+	for (size_t f = 0; f < fields.size(); ++f) {
+		for (size_t i = 0; i < fields[f].wires.size(); ++i) {
+			field_bits[fields[f].wires[i]] = {f, i};
+			initial_values[f] |= (uint64_t)fields[f].wires[i]->GetValue() << i;
+		}
+		bit_offsets.push_back(num_bits);
+		num_bits += fields[f].width;
+	}
+
+	// A source net whose wire is driven by the wire of a field takes the
+	// value of that field. The other ones keep the value of their wire.
+	vector<FieldBit> source_bits(sources.size());
+	vector<uint8_t> constant_values(sources.size());
+
+	for (size_t i = 0; i < sources.size(); ++i) {
+		const Wire *wire = netlist->GetNetWire(sources[i]).get();
+		constant_values[i] = wire->GetValue();
+
+		while (!field_bits.count(wire) && wire->GetWireInput()) {
+			wire = wire->GetWireInput();
+		}
+
+		const auto it = field_bits.find(wire);
+		if (it != field_bits.end()) {
+			source_bits[i] = it->second;
+		}
+	}
+
+	vector<vector<size_t>> pattern_toggles(batches.size(), vector<size_t>(NUM_LANES));
+	vector<vector<size_t>> bit_toggles(batches.size(), vector<size_t>(num_bits, 0));
+
+	// Captures count records starting at first into batch b, and counts the
+	// toggles of the wires of the fields.
+	auto capture = [&](size_t b, size_t first, size_t count) {
+		vector<uint64_t> prev_values(fields.size());
+		vector<uint64_t> values(fields.size());
+		vector<uint8_t> source_values = constant_values;
+
+		for (size_t f = 0; f < fields.size(); ++f) {
+			prev_values[f] = first ? file.GetValue(first - 1, f) : initial_values[f];
+		}
+
+		for (size_t p = 0; p < count; ++p) {
+			size_t toggles = 0;
+
+			for (size_t f = 0; f < fields.size(); ++f) {
+				values[f] = file.GetValue(first + p, f);
+
+				for (uint64_t changed = values[f] ^ prev_values[f]; changed; changed &= changed - 1) {
+					const size_t bit = __builtin_ctzll(changed);
+					toggles += fields[f].wires[bit]->GetNumOutputs();
+					bit_toggles[b][bit_offsets[f] + bit]++;
+				}
+
+				prev_values[f] = values[f];
+			}
+
+			for (size_t i = 0; i < sources.size(); ++i) {
+				if (source_bits[i].field != NO_FIELD) {
+					source_values[i] = (values[source_bits[i].field] >> source_bits[i].bit) & 1;
+				}
+			}
+
+			pattern_toggles[b][p] = toggles;
+			batches[b].AddPattern(source_values);
+		}
+	};
+
+	for (size_t begin = 0; begin < num_records; begin += batches.size() * NUM_LANES) {
+		const size_t end = min(num_records, begin + batches.size() * NUM_LANES);
+		const size_t num_batches = (end - begin + NUM_LANES - 1) / NUM_LANES;
+
+		for (size_t r = begin; r < end; ++r) {
+			handler(r);
+		}
+
+		vector<thread> threads;
+		for (size_t b = 1; b < num_batches; ++b) {
+			const size_t first = begin + b * NUM_LANES;
+			threads.emplace_back(capture, b, first, min(NUM_LANES, end - first));
+		}
+		capture(0, begin, min(NUM_LANES, end - begin));
+		for (auto &t : threads) {
+			t.join();
+		}
+
+		for (size_t b = 0; b < num_batches; ++b) {
+			for (size_t p = 0; p < batches[b].GetNumPatterns(); ++p) {
+				wire_toggles += pattern_toggles[b][p];
+				batch_wire_toggles.push_back(wire_toggles);
+			}
+		}
+
+		Commit();
+	}
+
+	if (!num_records) {
+		return;
+	}
+
+	// The wires of the fields take the values of the last record, and the
+	// toggles of all records. Their running total already has them.
+	for (size_t f = 0; f < fields.size(); ++f) {
+		const uint64_t value = file.GetValue(num_records - 1, f);
+
+		for (size_t i = 0; i < fields[f].wires.size(); ++i) {
+			Wire *wire = fields[f].wires[i];
+			size_t toggles = 0;
+
+			for (const auto &batch_toggles : bit_toggles) {
+				toggles += batch_toggles[bit_offsets[f] + i];
+			}
+
+			wire->SetValue((value >> i) & 1, true);
+			wire->Restore((value >> i) & 1, wire->GetNumToggles() + toggles * wire->GetNumOutputs());
+		}
+	}
+}
+
+// Captures the state of the system once all pending updates have been
+// simulated. The sweep engine keeps its state inside every component, like
+// in the committed values of the word-level kernels and transition tables,
+// so only the engines that simulate the netlist can take snapshots.
+const shared_ptr<const Snapshot> System::TakeSnapshot() {
+	if (engine == ENGINE::SWEEP) {
+		Error("Snapshots and forks can only be made by the engines that simulate the netlist, not by the \"sweep\" engine.\n");
+	}
+
+	Flush();
+
+	auto snapshot = make_shared<Snapshot>();
+	size_t w = 0;
+
+	snapshot->values.assign((wires.size() + 63) / 64, 0);
+	snapshot->toggles.reserve(wires.size());
+
+	for (const auto &[name, wire] : wires) {
+		if (wire) {
+			snapshot->values[w / 64] |= (uint64_t)wire->GetValue() << (w % 64);
+		}
+		snapshot->toggles.push_back(wire ? wire->GetNumToggles() : 0);
+		w++;
+	}
+
+	snapshot->wire_toggles = wire_toggles;
+	snapshot->net_state = net_state;
+	snapshot->netlist = netlist;
+	snapshot->held_nets = held_nets;
+	snapshot->held_values = held_values;
+
+	return snapshot;
+}
+
+// Continues from a snapshot, which can be restored any number of times.
+// The pattern-parallel engines simulate the updates that are still pending
+// first, unless the snapshot is of the same netlist: the next batch then
+// starts from the snapshot instead of the batch before it, so the updates
+// before and after the snapshot was restored are simulated at the same time.
+void System::Restore(const shared_ptr<const Snapshot> &snapshot) {
+	const bool parallel = engine == ENGINE::PARALLEL || engine == ENGINE::TIMED_PARALLEL;
+
+	if (!parallel || snapshot->netlist != netlist) {
+		Flush();
+	} else if (batches[current_batch].GetNumPatterns() && ++current_batch == batches.size()) {
+		Commit();
+	}
+
+	held_nets = snapshot->held_nets;
+	held_values = snapshot->held_values;
+	RestoreWires(*snapshot, false);
+	wire_toggles = snapshot->wire_toggles;
+
+	// The wires the netlist drives are restored once the patterns before
+	// are committed.
+	if (batch_wire_toggles.size()) {
+		batch_snapshots[current_batch] = snapshot;
+		return;
+	}
+
+	RestoreWires(*snapshot, true);
+	net_state = snapshot->net_state;
+
+	if (netlist != snapshot->netlist) {
+		UseNetlist(snapshot->netlist);
+	} else if (engine == ENGINE::TIMED) {
+		timing_wheel.Init(*netlist, net_state, gate_delays);
+	}
+}
+
+// Copies the state of the system into a fork that continues from it on its
+// own, once all pending updates have been simulated. A snapshot is forked
+// by restoring it first. The fork always uses the full netlist, so that
+// it can also change the held wires. Like snapshots, forks cannot be made
+// by the sweep engine, which does not simulate the netlist.
+const shared_ptr<SystemFork> System::Fork() {
+	if (engine == ENGINE::SWEEP) {
+		Error("Snapshots and forks can only be made by the engines that simulate the netlist, not by the \"sweep\" engine.\n");
+	}
+
+	Flush();
+
+	return make_shared<SystemFork>(full_netlist, net_state, wire_toggles);
+}
+
+// Restores either the wires that the netlist drives, or all other ones.
+void System::RestoreWires(const Snapshot &snapshot, bool driven_by_netlist) {
+	size_t w = 0;
+
+	for (const auto &[name, wire] : wires) {
+		if (wire && full_netlist->IsGateOutput(wire) == driven_by_netlist) {
+			wire->Restore((snapshot.values[w / 64] >> (w % 64)) & 1, snapshot.toggles[w]);
+		}
+		w++;
+	}
+}
+
+// Evaluates every component longest_path times, and the last of these passes
+// commits the values, so it is not an extra sweep. Counting the toggles from a
+// packed snapshot of the wires instead, like the netlist engines do, would
+// still take longest_path passes and add one over every wire. The commit pass
+// also runs the word-level kernels and clears the needs_update flags of the
+// primitive gates, which the propagating passes leave set.
+void System::UpdateSweep() {
 	for (size_t i = 0; i < longest_path - 1; ++i) {
 		for (const auto &[name, component] : components) {
 			if (component) {
@@ -240,17 +1068,176 @@ void System::Update() {
 	}
 }
 
-const size_t System::GetNumToggles() const {
-	size_t toggle_count = 0;
+// Evaluates every primitive gate exactly once in level order. All inputs of a
+// gate have settled by the time it is evaluated, so every net takes its new
+// value right away, and the toggles are counted once all gates are done.
+void System::UpdateLevelized() {
+	auto &values = net_state.values;
 
-	// Only wires keep track of how many times they toggled.
-	for (const auto &[name, wire] : wires) {
-		if (wire) {
-			toggle_count += wire->GetNumToggles();
+	netlist->LoadSources(net_state);
+
+	for (uint32_t gate = 0; gate < netlist->GetNumGates(); ++gate) {
+		netlist->Evaluate(gate, values.data(), values[netlist->GetGateOutput(gate)]);
+	}
+
+	netlist->Commit(net_state);
+	netlist->StoreOutputs(net_state);
+}
+
+// Same as UpdateLevelized(), but with the netlist compiled to native code.
+void System::UpdateCompiled() {
+	netlist->LoadSources(net_state);
+	compiled_netlist.Evaluate(net_state);
+	netlist->Commit(net_state);
+	netlist->StoreOutputs(net_state);
+}
+
+// Only evaluates the gates in the transitive fanout of the wires that
+// changed since the previous update.
+void System::UpdateEvent() {
+	auto &values = net_state.values;
+
+	for (const auto &net : netlist->GetSourceNets()) {
+		const uint8_t value = netlist->GetNetWire(net)->GetValue();
+
+		if (values[net] != value) {
+			values[net] = value;
+			event_queue.ScheduleFanout(net);
+		}
+	}
+
+	event_queue.Process(net_state);
+	netlist->StoreOutputs(net_state);
+}
+
+// Like the event-driven engine, but the gates have delays, so every
+// transition a net makes before it settles is counted.
+void System::UpdateTimed() {
+	auto &values = net_state.values;
+
+	for (const auto &net : netlist->GetSourceNets()) {
+		const uint8_t value = netlist->GetNetWire(net)->GetValue();
+
+		if (values[net] != value) {
+			values[net] = value;
+			timing_wheel.ScheduleFanout(net);
+		}
+	}
+
+	timing_wheel.Process(net_state);
+	netlist->StoreOutputs(net_state);
+}
+
+// Captures the current values of the inputs as a pattern, and only
+// simulates once every thread has a full batch of patterns.
+void System::UpdateParallel() {
+	batch_wire_toggles.push_back(wire_toggles);
+	batches[current_batch].AddPattern();
+
+	if (batches[current_batch].IsFull() && ++current_batch == batches.size()) {
+		Commit();
+	}
+}
+
+// Simulates the captured patterns, and commits them one by one so that
+// the commit handler sees the outputs and toggles of each pattern.
+//
+// Each batch holds a contiguous part of the patterns and is simulated by
+// its own thread. The toggles of a pattern only depend on the values of
+// that pattern and the one before it, so each batch is primed with the
+// values of the last pattern of the batch before it, or with a snapshot
+// that was restored before its first pattern. This gives exactly the same
+// toggles as simulating all batches one after the other.
+void System::Commit() {
+	size_t num_batches = 0;
+	while (num_batches < batches.size() && batches[num_batches].GetNumPatterns()) {
+		num_batches++;
+	}
+
+	auto simulate = [&](size_t b) {
+		if (batch_snapshots[b]) {
+			batches[b].Prime(batch_snapshots[b]->net_state);
+		} else if (b == 0) {
+			batches[b].Prime(net_state);
+		} else {
+			batches[b].Prime(batches[b - 1]);
 		}
+		batches[b].Evaluate();
+	};
+
+	// Batches are primed from the batch before them while that one is
+	// evaluated, so they must not change once the threads are started.
+	for (size_t b = 0; b < num_batches; ++b) {
+		batches[b].FillUnusedPatterns();
+	}
+
+	vector<thread> threads;
+	for (size_t b = 1; b < num_batches; ++b) {
+		threads.emplace_back(simulate, b);
+	}
+	simulate(0);
+	for (auto &t : threads) {
+		t.join();
+	}
+
+	for (size_t b = 0; b < num_batches; ++b) {
+		if (batch_snapshots[b]) {
+			net_state.toggles = batch_snapshots[b]->net_state.toggles;
+		}
+		batches[b].MergeToggles(net_state);
+	}
+
+	const auto &last_batch = batches[num_batches - 1];
+	for (size_t n = 0; n < net_state.values.size(); ++n) {
+		net_state.values[n] = last_batch.GetLastValue(n);
+	}
+
+	const auto &output_nets = netlist->GetOutputNets();
+	size_t pattern = 0;
+
+	for (size_t b = 0; b < num_batches; ++b) {
+		if (batch_snapshots[b]) {
+			RestoreWires(*batch_snapshots[b], true);
+			net_state.num_toggles = batch_snapshots[b]->net_state.num_toggles;
+		}
+
+		for (size_t p = 0; p < batches[b].GetNumPatterns(); ++p, ++pattern) {
+			for (const auto &net : output_nets) {
+				netlist->GetNetWire(net)->SyncValue(batches[b].GetValue(net, p));
+			}
+
+			net_state.num_toggles += batches[b].GetToggles(p);
+			glitch_toggles += batches[b].GetGlitchToggles(p);
+			committed_wire_toggles = batch_wire_toggles[pattern];
+
+			if (commit_handler) {
+				commit_handler();
+			}
+		}
+
+		batches[b].Clear();
+	}
+
+	// A snapshot that was restored after the last pattern.
+	if (num_batches < batches.size() && batch_snapshots[num_batches]) {
+		RestoreWires(*batch_snapshots[num_batches], true);
+		net_state = batch_snapshots[num_batches]->net_state;
+	}
+
+	fill(batch_snapshots.begin(), batch_snapshots.end(), nullptr);
+	committed_wire_toggles.reset();
+	batch_wire_toggles.clear();
+	current_batch = 0;
+}
+
+// The wires keep wire_toggles up to date, so they do not have to be visited.
+const size_t System::GetNumToggles() const {
+	if (!netlist) {
+		return wire_toggles;
 	}
 
-	return toggle_count;
+	// The toggles of wires driven by the netlist are kept in its state.
+	return committed_wire_toggles.value_or(wire_toggles) + net_state.num_toggles;
 }
 
 const comp_t System::GetComponent(const string &comp_name) const {
@@ -3,15 +3,46 @@
 
 #include "main.h"
 
+// The state of a system between two updates. Only the values and toggles
+// are copied, the netlist is shared with the system and its other snapshots.
+struct Snapshot {
+	vector<uint64_t> values; // Value of each wire of the system, one bit per wire.
+	vector<size_t> toggles; // Toggles of each wire of the system.
+	size_t wire_toggles = 0;
+	NetState net_state;
+	shared_ptr<Netlist> netlist = nullptr;
+	vector<uint32_t> held_nets;
+	vector<uint8_t> held_values;
+
+	const size_t GetNumToggles() const {return wire_toggles + net_state.num_toggles;}
+};
+
 class System {
 public:
 	void AddComponent(comp_t component);
 	void AddWire(wire_t wire);
 	void AddWireBundle(wb_t wires);
 	void SetWireInformation(const vector<wi_t> &wire_info) {wire_information = wire_info;};
+	void BuildArena();
 	void FindLongestPathInSystem();
-	void FindInitialState();
+	void FindInitialState(bool use_cache);
+	void Levelize();
+	void Elaborate();
 	void Update();
+	void UpdateFromFile(const StimulusFile &file, const function<void(size_t)> &handler);
+	void Flush();
+	const shared_ptr<const Snapshot> TakeSnapshot();
+	void Restore(const shared_ptr<const Snapshot> &snapshot);
+	const shared_ptr<SystemFork> Fork();
+	void HoldWires(const vector<wire_t> &held_wires);
+	void SetCommitHandler(function<void()> handler) {commit_handler = handler;}
+	void SetEngine(ENGINE _engine) {engine = _engine;}
+	void SetNumThreads(size_t _num_threads) {num_threads = _num_threads;}
+	void SetSplit(SPLIT _split) {split = _split;}
+	void SetWordLevel(bool enable);
+	void BuildTransitionTables(size_t max_entries);
+	void BuildResponseCaches(size_t max_entries, const vector<string> &types);
+	void SetGateDelays(const map<Netlist::GATE, size_t> &delays) {gate_delays = delays;}
 
 	const size_t GetNumToggles() const;
 	const size_t GetNumComponents() const {return components.size();}
@@ -29,11 +60,37 @@ public:
 	const vector<wb_t> &GetInputWireBundles() const {return input_bundles;}
 	const vector<wb_t> &GetOutputWireBundles() const {return output_bundles;}
 	const size_t GetLongestPath() const {return longest_path;}
+	const ENGINE GetEngine() const {return engine;}
+	const size_t GetNumThreads() const {return num_threads;}
+	const SPLIT GetSplit() const {return split;}
+	const size_t GetNumLevels() const {return num_levels;}
+	const vector<size_t> &GetLevelWidths() const {return level_widths;}
+	const size_t GetNumEvents() const {return engine == ENGINE::TIMED ? timing_wheel.GetNumEvents() : event_queue.GetNumEvents();}
+	const size_t GetNumGlitchToggles() const {return engine == ENGINE::TIMED ? timing_wheel.GetNumGlitchToggles() : glitch_toggles;}
+	const size_t GetNumSpecializations() const {return num_specializations;}
+	const map<string, vector<const ResponseCache *>> &GetResponseCaches() const {return response_caches;}
+	const Arena &GetArena() const {return *arena;}
+	const vector<comp_t> &GetLevelizedGates() const {return levelized_gates;}
+	const shared_ptr<Netlist> &GetNetlist() const {return netlist;}
+	const NetState &GetNetState() const {return net_state;}
 
 	const void GenerateVHDL(const string &config_filename, const string &path) const;
 protected:
 
 private:
+	void UpdateSweep();
+	void UpdateLevelized();
+	void UpdateEvent();
+	void UpdateParallel();
+	void UpdateCompiled();
+	void UpdateTimed();
+	void Commit();
+	void InitEngine();
+	void UseNetlist(const shared_ptr<Netlist> &_netlist);
+	void RestoreWires(const Snapshot &snapshot, bool driven_by_netlist);
+	const bool HeldValuesChanged() const;
+	void Specialize();
+
 	comp_map_t components;
 	wire_map_t wires;
 	wb_map_t   wire_bundles;
@@ -50,6 +107,34 @@ private:
 	vector<wb_t> internal_bundles;
 
 	size_t longest_path = 0;
+	unique_ptr<Arena> arena = make_unique<Arena>(); // Handles of all wires and components, and the connections of each wire. Held by pointer, since the wires point to it.
+
+	ENGINE engine = ENGINE::SWEEP;
+	vector<comp_t> levelized_gates; // All primitive gates, sorted by topological level.
+	size_t num_levels = 0;
+	vector<size_t> level_widths; // Number of gates in each level.
+	shared_ptr<Netlist> netlist = nullptr; // Flattened system, used by all engines except the sweep.
+	shared_ptr<Netlist> full_netlist = nullptr; // The netlist before it was specialized for the held wires, and the one of the forks.
+	vector<uint32_t> held_nets; // Source nets of the held wires.
+	vector<uint8_t> held_values; // Values of the held nets that the netlist is specialized for, empty if it is not.
+	size_t num_specializations = 0;
+	map<string, vector<const ResponseCache *>> response_caches; // By the type of the components that own them.
+	NetState net_state;
+	size_t wire_toggles = 0; // Running total of the toggles of the wires in wires, except the ones the netlist drives.
+	EventQueue event_queue; // Only used by the event-driven engine.
+	TimingWheel timing_wheel; // Only used by the timed engine.
+	map<Netlist::GATE, size_t> gate_delays; // Delays of the gate types that do not have a delay of 1.
+	size_t num_threads = 1;
+	SPLIT split = SPLIT::TIME; // How the pattern-parallel engine uses the threads.
+	unique_ptr<ThreadPool> thread_pool = nullptr; // Only used when splitting the levels.
+	vector<PatternParallel> batches; // Only used by the pattern-parallel engine, one batch per thread when splitting the time.
+	size_t current_batch = 0; // The batch that captures the next pattern.
+	vector<size_t> batch_wire_toggles; // wire_toggles when each pattern of the batches was captured.
+	vector<shared_ptr<const Snapshot>> batch_snapshots; // The snapshot each batch starts from instead of the batch before it, if any.
+	optional<size_t> committed_wire_toggles; // Set while the patterns of the batches are being committed.
+	size_t glitch_toggles = 0; // Glitch toggles of the committed patterns of the timed pattern-parallel engine.
+	CompiledNetlist compiled_netlist; // Only used by the compiled engine.
+	function<void()> commit_handler = nullptr; // Called after every update, once its results are available.
 };
 
 #endif // SYSTEM_H
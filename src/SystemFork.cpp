@@ -0,0 +1,77 @@
+#include "main.h"
+
+/*
+  A fork evaluates every gate of the netlist once per update in level
+  order, like the levelized engine, so it counts the toggles of the
+  settled values whatever engine the system it was forked from uses. The
+  wires of the system are only used to look up their nets, and are never
+  read or written, so the system and its forks do not share any state
+  that changes.
+*/
+
+SystemFork::SystemFork(const shared_ptr<const Netlist> &_netlist, const NetState &state, size_t _wire_toggles)
+	: netlist(_netlist)
+	, net_state(state)
+	, wire_toggles(_wire_toggles) {
+	netlist->InitCommitted(net_state);
+}
+
+// Sets an input of the fork. Like a wire of the system, the toggle is
+// counted for every component and wire that the input drives.
+void SystemFork::SetValue(const wire_t &wire, bool val) {
+	const uint32_t net = GetNet(wire);
+
+	if (netlist->IsGateOutput(wire)) {
+		Error("Wire \"" + wire->GetName() + "\" is driven by a gate, so its value cannot be set in a fork.\n");
+	}
+
+	if (net_state.values[net] != val) {
+		net_state.values[net] = val;
+		net_state.toggles[net]++;
+		wire_toggles += wire->GetNumOutputs();
+	}
+}
+
+void SystemFork::SetValue(const wb_t &wires, int64_t value) {
+	value = wires->From2CValue(value);
+
+	for (size_t i = 0; i < wires->GetSize(); ++i) {
+		SetValue((*wires)[i], (value >> i) & 1);
+	}
+}
+
+void SystemFork::Update() {
+	auto &values = net_state.values;
+
+	for (uint32_t gate = 0; gate < netlist->GetNumGates(); ++gate) {
+		netlist->Evaluate(gate, values.data(), values[netlist->GetGateOutput(gate)]);
+	}
+
+	netlist->Commit(net_state);
+}
+
+const bool SystemFork::GetValue(const wire_t &wire) const {
+	return net_state.values[GetNet(wire)];
+}
+
+const int64_t SystemFork::GetValue(const wb_t &wires) const {
+	int64_t result = 0;
+
+	for (size_t i = 0; i < wires->GetSize(); ++i) {
+		if (GetValue((*wires)[i])) {
+			result |= (1ul << i);
+		}
+	}
+
+	return result;
+}
+
+const uint32_t SystemFork::GetNet(const wire_t &wire) const {
+	const auto net = netlist->GetNet(wire);
+
+	if (!net) {
+		Error("Wire \"" + wire->GetName() + "\" is not connected to any gate, so a fork does not have its value.\n");
+	}
+
+	return net.value();
+}
@@ -0,0 +1,31 @@
+#ifndef SYSTEMFORK_H
+#define SYSTEMFORK_H
+
+#include "main.h"
+
+// An independent copy of the state of a System, made by System::Fork().
+// The netlist is shared with the system and all of its other forks, and
+// only the values and toggles of the nets are copied, so every fork can
+// continue from the same state in a thread of its own.
+class SystemFork {
+public:
+	SystemFork(const shared_ptr<const Netlist> &_netlist, const NetState &state, size_t _wire_toggles);
+
+	void SetValue(const wire_t &wire, bool val);
+	void SetValue(const wb_t &wires, int64_t value);
+	void Update();
+
+	const bool GetValue(const wire_t &wire) const;
+	const int64_t GetValue(const wb_t &wires) const;
+	const int64_t Get2CValue(const wb_t &wires) const {return wires->To2CValue(GetValue(wires));}
+	const size_t GetNumToggles() const {return wire_toggles + net_state.num_toggles;}
+	const NetState &GetNetState() const {return net_state;}
+private:
+	const uint32_t GetNet(const wire_t &wire) const;
+
+	shared_ptr<const Netlist> netlist;
+	NetState net_state;
+	size_t wire_toggles = 0; // Toggles of the system that the netlist does not count, like those of the inputs.
+};
+
+#endif // SYSTEMFORK_H
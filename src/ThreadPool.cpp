@@ -0,0 +1,121 @@
+#include "main.h"
+
+/*
+  Work-stealing thread pool.
+
+  Run() spreads the tasks over one queue per thread, and the calling thread
+  works on the first queue. A thread takes tasks from the front of its own
+  queue, and once that is empty it steals tasks from the back of the
+  queues of the other threads. Run() returns when all tasks are done, so
+  consecutive calls are separated by a barrier.
+*/
+
+ThreadPool::ThreadPool(size_t _num_threads)
+	: num_threads(max(_num_threads, (size_t)1))
+{
+	for (size_t i = 0; i < num_threads; ++i) {
+		queues.emplace_back(make_unique<TaskQueue>());
+	}
+
+	// Thread 0 is the one that calls Run().
+	for (size_t i = 1; i < num_threads; ++i) {
+		workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		lock_guard<mutex> guard(run_lock);
+		stopping = true;
+	}
+	run_started.notify_all();
+
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+// Runs task_function(task, thread) for every task in [0, num_tasks), and
+// returns once all of them are done.
+void ThreadPool::Run(size_t num_tasks, const function<void(size_t, size_t)> &task_function) {
+	if (num_tasks == 0) {
+		return;
+	}
+
+	job = &task_function;
+	remaining_tasks.store(num_tasks, memory_order_release);
+
+	for (size_t t = 0; t < num_tasks; ++t) {
+		auto &queue = *queues[t % num_threads];
+		lock_guard<mutex> guard(queue.lock);
+		queue.tasks.push_back(t);
+	}
+
+	{
+		lock_guard<mutex> guard(run_lock);
+		generation++;
+	}
+	run_started.notify_all();
+
+	Work(0);
+
+	// Other threads may still be busy with stolen tasks.
+	while (remaining_tasks.load(memory_order_acquire) != 0) {
+		this_thread::yield();
+	}
+}
+
+void ThreadPool::WorkerLoop(size_t thread) {
+	size_t seen_generation = 0;
+
+	while (true) {
+		{
+			unique_lock<mutex> guard(run_lock);
+			run_started.wait(guard, [&]() {return stopping || generation != seen_generation;});
+
+			if (stopping) {
+				return;
+			}
+
+			seen_generation = generation;
+		}
+
+		Work(thread);
+	}
+}
+
+void ThreadPool::Work(size_t thread) {
+	size_t task;
+
+	while (PopTask(thread, task)) {
+		(*job)(task, thread);
+		remaining_tasks.fetch_sub(1, memory_order_acq_rel);
+	}
+}
+
+// Takes a task from the own queue, or steals one from another queue.
+const bool ThreadPool::PopTask(size_t thread, size_t &task) {
+	{
+		auto &queue = *queues[thread];
+		lock_guard<mutex> guard(queue.lock);
+
+		if (!queue.tasks.empty()) {
+			task = queue.tasks.front();
+			queue.tasks.pop_front();
+			return true;
+		}
+	}
+
+	for (size_t i = 1; i < num_threads; ++i) {
+		auto &queue = *queues[(thread + i) % num_threads];
+		lock_guard<mutex> guard(queue.lock);
+
+		if (!queue.tasks.empty()) {
+			task = queue.tasks.back();
+			queue.tasks.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
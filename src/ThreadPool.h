@@ -0,0 +1,36 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include "main.h"
+
+class ThreadPool {
+public:
+	ThreadPool(size_t _num_threads);
+	~ThreadPool();
+
+	void Run(size_t num_tasks, const function<void(size_t task, size_t thread)> &task_function);
+
+	const size_t GetNumThreads() const {return num_threads;}
+private:
+	struct TaskQueue {
+		mutex lock;
+		deque<size_t> tasks;
+	};
+
+	void WorkerLoop(size_t thread);
+	void Work(size_t thread);
+	const bool PopTask(size_t thread, size_t &task);
+
+	size_t num_threads;
+	vector<thread> workers;
+	vector<unique_ptr<TaskQueue>> queues; // One queue per thread, including the calling thread.
+	const function<void(size_t, size_t)> *job = nullptr;
+	atomic<size_t> remaining_tasks = 0;
+
+	mutex run_lock;
+	condition_variable run_started;
+	size_t generation = 0; // Incremented by every Run().
+	bool stopping = false;
+};
+
+#endif // THREADPOOL_H
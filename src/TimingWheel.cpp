@@ -0,0 +1,134 @@
+#include "main.h"
+
+/*
+  Timing wheel for simulating a netlist with gate delays.
+
+  Every gate has a delay of one time step, or the delay that was given for
+  its type. When a net changes at time t, the gates that read it are
+  evaluated at t, and their new outputs are applied at t + delay. This is a
+  transport delay: every pulse on an input travels to the output, however
+  short it is. Since no delay is larger than the number of slots in the
+  wheel minus one, the events of a time step never wrap around to a slot
+  that has not been processed yet.
+
+  Unlike the zero-delay engines, a net can change several times before it
+  settles. Every change is counted as a toggle. The toggles of a net that
+  do not change its settled value are glitches, which are also counted
+  separately.
+*/
+
+// The counters are kept, so that the wheel can move to another netlist
+// over the same nets between updates.
+void TimingWheel::Init(const Netlist &_netlist, const NetState &state, const map<Netlist::GATE, size_t> &delays) {
+	netlist = &_netlist;
+
+	size_t max_delay = 1;
+	gate_delays.resize(netlist->GetNumGates());
+
+	for (uint32_t gate = 0; gate < netlist->GetNumGates(); ++gate) {
+		const auto it = delays.find(netlist->GetGateType(gate));
+
+		gate_delays[gate] = (it != delays.end() ? it->second : 1);
+		max_delay = max(max_delay, (size_t)gate_delays[gate]);
+	}
+
+	slots.clear();
+	slots.resize(max_delay + 1);
+	gates.clear();
+	scheduled_at.assign(netlist->GetNumGates(), 0);
+	projected = state.values;
+	time = 0;
+	num_pending = 0;
+
+	changed_nets.clear();
+	initial_values.assign(netlist->GetNumNets(), 0);
+	changed.assign(netlist->GetNumNets(), false);
+}
+
+// Schedules all gates that read the given net for evaluation at the
+// current time step.
+void TimingWheel::ScheduleFanout(uint32_t net) {
+	const uint32_t *fanout = netlist->GetFanout(net);
+	const size_t fanout_size = netlist->GetFanoutSize(net);
+
+	for (size_t i = 0; i < fanout_size; ++i) {
+		const uint32_t gate = fanout[i];
+
+		if (scheduled_at[gate] != time + 1) {
+			scheduled_at[gate] = time + 1;
+			gates.push_back(gate);
+		}
+	}
+}
+
+// Advances time until all nets have settled, and returns how many gates
+// were evaluated.
+const size_t TimingWheel::Process(NetState &state) {
+	auto &values = state.values;
+	const size_t prev_toggles = state.num_toggles;
+	const size_t prev_events = num_events;
+
+	Evaluate(state);
+
+	while (num_pending) {
+		auto &slot = slots[++time % slots.size()];
+
+		for (const auto &[net, value] : slot) {
+			if (values[net] != value) {
+				if (!changed[net]) {
+					changed[net] = true;
+					initial_values[net] = values[net];
+					changed_nets.push_back(net);
+				}
+
+				values[net] = value;
+				state.toggles[net]++;
+				state.num_toggles += netlist->GetToggleWeight(net);
+				ScheduleFanout(net);
+			}
+		}
+
+		num_pending -= slot.size();
+		slot.clear();
+
+		Evaluate(state);
+	}
+
+	// Only the nets that settled on a different value toggled functionally.
+	size_t functional_toggles = 0;
+
+	for (const auto &net : changed_nets) {
+		if (values[net] != initial_values[net]) {
+			functional_toggles += netlist->GetToggleWeight(net);
+		}
+		changed[net] = false;
+	}
+	changed_nets.clear();
+
+	num_glitch_toggles += state.num_toggles - prev_toggles - functional_toggles;
+
+	// The next update starts at a new time step, so that the gates its
+	// inputs schedule are not mistaken for the ones of this update.
+	++time;
+
+	return num_events - prev_events;
+}
+
+// Evaluates the gates of the current time step, and schedules the changes
+// of their outputs.
+void TimingWheel::Evaluate(NetState &state) {
+	for (const auto &gate : gates) {
+		const uint32_t out = netlist->GetGateOutput(gate);
+		uint8_t value;
+		netlist->Evaluate(gate, state.values.data(), value);
+
+		if (projected[out] != value) {
+			projected[out] = value;
+			slots[(time + gate_delays[gate]) % slots.size()].push_back({out, value});
+			num_pending++;
+		}
+	}
+
+	num_events += gates.size();
+	gates.clear();
+}
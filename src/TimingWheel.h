@@ -0,0 +1,43 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include "main.h"
+
+class TimingWheel {
+public:
+	void Init(const Netlist &_netlist, const NetState &state, const map<Netlist::GATE, size_t> &delays);
+	void ScheduleFanout(uint32_t net);
+	const size_t Process(NetState &state);
+
+	const size_t GetMaxDelay() const {return slots.size() - 1;}
+	const size_t GetNumEvents() const {return num_events;}
+	const size_t GetNumGlitchToggles() const {return num_glitch_toggles;}
+private:
+	// A net that takes a new value at the time of the slot it is in.
+	struct NetEvent {
+		uint32_t net;
+		uint8_t value;
+	};
+
+	void Evaluate(NetState &state);
+
+	const Netlist *netlist = nullptr;
+	vector<uint32_t> gate_delays;
+	vector<vector<NetEvent>> slots; // Net events of the next max_delay + 1 time steps.
+	vector<uint32_t> gates; // Gates to evaluate at the current time step.
+	vector<uint64_t> scheduled_at; // Time step + 1 at which each gate was last scheduled.
+	vector<uint8_t> projected; // Value of each net once all of its pending events are applied.
+	uint64_t time = 0;
+	size_t num_pending = 0; // Number of net events in all slots.
+
+	// Nets that changed during the current update, and their values
+	// before the update.
+	vector<uint32_t> changed_nets;
+	vector<uint8_t> initial_values;
+	vector<uint8_t> changed;
+
+	size_t num_events = 0; // Total number of gate evaluations.
+	size_t num_glitch_toggles = 0; // Toggles that did not change the settled value of a net, weighted like Wire does.
+};
+
+#endif // TIMINGWHEEL_H
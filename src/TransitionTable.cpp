@@ -0,0 +1,296 @@
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include "main.h"
+
+/*
+  Lookup tables for small composite components.
+
+  Every wire that a gate of the component reads but none of them drives
+  is an input. For n inputs, the table has 2^n entries, and entry i holds
+  the settled values of all wires that the gates drive when bit k of i is
+  the value of input k. All entries are computed in a single pass over the
+  gates in topological order, where bit i of the value of a wire belongs to
+  entry i.
+
+  Only settled values are counted by the sweep engine, so the toggles of a
+  transition from one entry to the next are the bits in which they differ.
+  Only the wires of those bits are set, so every wire counts exactly the
+  toggles it would count with the gates.
+
+  Components with the same gates share their entries, which are also kept
+  in the cache directory and named after a hash of the gates, so they are
+  only computed once.
+*/
+
+// A gate of the component. Local net 0 is the constant 0 of unconnected
+// inputs, followed by the driven wires and then the inputs.
+struct LocalGate {
+	Netlist::GATE type;
+	array<uint32_t, 3> in;
+	uint32_t out; // NO_NET if the output is not connected.
+};
+
+static constexpr uint32_t NO_NET = UINT32_MAX;
+
+// Bit i of the value of input k for the first 64 entries, for k < 6.
+static constexpr uint64_t input_patterns[] = {
+	0xaaaaaaaaaaaaaaaaULL, 0xccccccccccccccccULL, 0xf0f0f0f0f0f0f0f0ULL,
+	0xff00ff00ff00ff00ULL, 0xffff0000ffff0000ULL, 0xffffffff00000000ULL
+};
+
+// Entries of all tables built so far, by the description of their gates.
+static unordered_map<string, shared_ptr<const vector<uint64_t>>> built_tables;
+
+// Describes the gates in a way that only depends on how they are connected,
+// not on the names of their wires.
+static const string Describe(size_t num_inputs, size_t num_wires, const vector<LocalGate> &gates) {
+	stringstream description;
+
+	description << num_inputs << ' ' << num_wires << '\n';
+	for (const auto &gate : gates) {
+		description << (int)gate.type << ' ' << gate.in[0] << ' ' << gate.in[1] << ' ' << gate.in[2] << ' ' << gate.out << '\n';
+	}
+
+	return description.str();
+}
+
+// Evaluates the gates for 64 entries at a time, and stores the values of
+// the driven wires of each entry.
+static void BuildEntries(size_t num_inputs, size_t num_wires, const vector<LocalGate> &gates, vector<uint64_t> &entries) {
+	const size_t num_entries = 1ULL << num_inputs;
+	const size_t words_per_entry = max((size_t)1, (num_wires + 63) / 64);
+	const size_t entries_per_chunk = min(num_entries, (size_t)64);
+	vector<uint64_t> values(1 + num_wires + num_inputs, 0);
+
+	entries.assign(num_entries * words_per_entry, 0);
+
+	for (size_t chunk = 0; chunk < num_entries / entries_per_chunk; ++chunk) {
+		for (size_t k = 0; k < num_inputs; ++k) {
+			if (k < 6) {
+				values[1 + num_wires + k] = input_patterns[k];
+			} else {
+				values[1 + num_wires + k] = ((chunk >> (k - 6)) & 1) ? ~0ULL : 0;
+			}
+		}
+
+		for (const auto &gate : gates) {
+			uint64_t value;
+			Netlist::Evaluate(gate.type, gate.in.data(), values.data(), value);
+
+			if (gate.out != NO_NET) {
+				values[gate.out] = value;
+			}
+		}
+
+		for (size_t w = 0; w < num_wires; ++w) {
+			const uint64_t bits = values[1 + w];
+
+			for (size_t e = 0; e < entries_per_chunk; ++e) {
+				if ((bits >> e) & 1) {
+					entries[(chunk * 64 + e) * words_per_entry + w / 64] |= 1ULL << (w % 64);
+				}
+			}
+		}
+	}
+}
+
+// Builds the table of a component if all of its subcomponents are built
+// from primitive gates without loops, and it has at most max_entries input
+// combinations. Otherwise the table is not valid.
+TransitionTable::TransitionTable(const comp_t &component, size_t max_entries) {
+	vector<comp_t> gates;
+
+	if (component->GetSubcomponents().empty() || !Netlist::CollectGates(component, gates)) {
+		return;
+	}
+
+	// The gate that drives each wire.
+	unordered_map<const Wire *, uint32_t> drivers;
+
+	for (uint32_t g = 0; g < gates.size(); ++g) {
+		const auto &out = gates[g]->GetWire(PORTS::O);
+
+		if (out) {
+			if (!drivers.emplace(out.get(), wires.size()).second) {
+				return;
+			}
+			wires.push_back(out.get());
+		}
+	}
+
+	const size_t num_wires = wires.size();
+	vector<LocalGate> local_gates(gates.size());
+	vector<uint32_t> driver_gates(num_wires);
+	unordered_map<const Wire *, uint32_t> input_index;
+
+	for (uint32_t g = 0; g < gates.size(); ++g) {
+		const auto [type, ports] = Netlist::IdentifyGate(gates[g]).value();
+		auto &local = local_gates[g];
+
+		local.type = type;
+		local.in = {0, 0, 0};
+		local.out = NO_NET;
+
+		for (size_t k = 0; k < ports.size(); ++k) {
+			const auto &wire = gates[g]->GetWire(ports[k]);
+
+			if (!wire) {
+				continue;
+			}
+
+			const auto it = drivers.find(wire.get());
+			if (it != drivers.end()) {
+				local.in[k] = 1 + it->second;
+				continue;
+			}
+
+			// A wire that is driven by another wire could be driven from
+			// inside the component.
+			if (wire->GetWireInput()) {
+				wires.clear();
+				inputs.clear();
+				return;
+			}
+
+			const auto [input, added] = input_index.emplace(wire.get(), inputs.size());
+			if (added) {
+				inputs.push_back(wire.get());
+			}
+			local.in[k] = 1 + num_wires + input->second;
+		}
+
+		const auto &out = gates[g]->GetWire(PORTS::O);
+		if (out) {
+			local.out = 1 + drivers.at(out.get());
+			driver_gates[local.out - 1] = g;
+		}
+	}
+
+	if (inputs.size() >= 32 || (1ULL << inputs.size()) > max_entries) {
+		wires.clear();
+		inputs.clear();
+		return;
+	}
+
+	// Sort the gates so that every gate comes after the gates that drive
+	// its inputs.
+	vector<LocalGate> sorted;
+	vector<uint8_t> state(gates.size(), 0); // 1 while visiting, 2 once sorted.
+	function<bool(uint32_t)> visit = [&](uint32_t g) {
+		if (state[g] == 2) {
+			return true;
+		} else if (state[g] == 1) {
+			return false;
+		}
+
+		state[g] = 1;
+		for (const auto &net : local_gates[g].in) {
+			if (net >= 1 && net <= num_wires && !visit(driver_gates[net - 1])) {
+				return false;
+			}
+		}
+		state[g] = 2;
+		sorted.push_back(local_gates[g]);
+		return true;
+	};
+
+	for (uint32_t g = 0; g < gates.size(); ++g) {
+		if (!visit(g)) {
+			wires.clear();
+			inputs.clear();
+			return;
+		}
+	}
+
+	words_per_entry = max((size_t)1, (num_wires + 63) / 64);
+
+	const string description = Describe(inputs.size(), num_wires, sorted);
+	const auto it = built_tables.find(description);
+
+	if (it != built_tables.end()) {
+		entries = it->second;
+		return;
+	}
+
+	stringstream name;
+	name << hex << setw(16) << setfill('0') << Hash(description);
+
+	// The tables are only kept in the cache directory if it can be used.
+	// Otherwise they are built for this run only, with a single warning.
+	static bool warned = false;
+	string problem;
+	const auto cache_path = FindCacheDirectory(problem);
+
+	if (!cache_path && !warned) {
+		cout << "[Warning] " << problem << "The transition tables are not cached.\n";
+		warned = true;
+	}
+
+	const size_t num_words = ((size_t)1 << inputs.size()) * words_per_entry;
+	auto table = make_shared<vector<uint64_t>>();
+	string table_path;
+
+	if (cache_path) {
+		table_path = (std::filesystem::path(*cache_path) / (name.str() + ".table")).string();
+		cached = ReadCacheFile(table_path, description, num_words, *table);
+	}
+
+	if (!cached) {
+		BuildEntries(inputs.size(), num_wires, sorted, *table);
+
+		if (cache_path) {
+			WriteCacheFile(table_path, description, *table);
+		}
+	}
+
+	entries = table;
+	built_tables[description] = entries;
+}
+
+// Sets the wires to the entry of the current values of the inputs. While
+// propagating, only the current values of the wires are set. Otherwise the
+// values are committed, which also sets the wires whose current value is
+// not the one that is committed.
+void TransitionTable::Evaluate(bool propagating) {
+	size_t index = 0;
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		index |= (size_t)inputs[i]->GetValue() << i;
+	}
+
+	if (index == current && (propagating || index == committed)) {
+		return;
+	}
+
+	const uint64_t *next = GetEntry(index);
+	const bool set_all = current == NONE || (!propagating && committed == NONE);
+
+	for (size_t w = 0; w < words_per_entry; ++w) {
+		uint64_t changed = ~0ULL;
+
+		if (!set_all) {
+			changed = next[w] ^ GetEntry(current)[w];
+
+			if (!propagating) {
+				changed |= next[w] ^ GetEntry(committed)[w];
+			}
+		}
+
+		if (w == words_per_entry - 1 && wires.size() % 64) {
+			changed &= (1ULL << (wires.size() % 64)) - 1;
+		} else if (wires.empty()) {
+			changed = 0;
+		}
+
+		while (changed) {
+			const size_t bit = __builtin_ctzll(changed);
+			wires[w * 64 + bit]->SetValue((next[w] >> bit) & 1, propagating);
+			changed &= changed - 1;
+		}
+	}
+
+	current = index;
+	if (!propagating) {
+		committed = index;
+	}
+}
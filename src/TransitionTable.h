@@ -0,0 +1,37 @@
+#ifndef TRANSITIONTABLE_H
+#define TRANSITIONTABLE_H
+
+#include "main.h"
+
+// Settled values of all wires inside a small composite component for every
+// combination of its inputs, so that the component can be evaluated with a
+// single lookup instead of its gates.
+class TransitionTable {
+public:
+	TransitionTable(const comp_t &component, size_t max_entries);
+
+	void Evaluate(bool propagating);
+
+	const bool IsValid() const {return entries != nullptr;}
+	const bool IsCached() const {return cached;}
+	const size_t GetNumInputs() const {return inputs.size();}
+	const size_t GetNumWires() const {return wires.size();}
+	const vector<uint64_t> *GetEntries() const {return entries.get();}
+private:
+	static constexpr size_t NONE = SIZE_MAX;
+
+	const uint64_t *GetEntry(size_t index) const {return &(*entries)[index * words_per_entry];}
+
+	vector<Wire *> inputs; // Bit i of the index of an entry is the value of inputs[i].
+	vector<Wire *> wires; // The wires that the gates of the component drive, in the order of the bits of an entry.
+	size_t words_per_entry = 1;
+	shared_ptr<const vector<uint64_t>> entries = nullptr; // Shared by all components with the same gates.
+	bool cached = false; // True if the entries were read from the cache directory.
+
+	// The entries that the current and the committed values of the wires
+	// were last set to.
+	size_t current = NONE;
+	size_t committed = NONE;
+};
+
+#endif // TRANSITIONTABLE_H
@@ -1,3 +1,8 @@
+#include <unistd.h>
+#include <pwd.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <filesystem>
 #include "main.h"
 
 void Error(const string &err) {
@@ -5,6 +10,167 @@ void Error(const string &err) {
 	exit(1);
 }
 
+// 64-bit FNV-1a.
+const uint64_t Hash(const string &text) {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	for (const auto &c : text) {
+		hash ^= (unsigned char)c;
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+// True if the path is a directory or regular file, and not a symbolic
+// link, that is owned by the current user and cannot be written by anyone
+// else.
+static const bool IsPrivate(const string &path, bool directory) {
+	struct stat st;
+
+	if (lstat(path.c_str(), &st) < 0 ||
+		(directory ? !S_ISDIR(st.st_mode) : !S_ISREG(st.st_mode)))
+	{
+		return false;
+	}
+
+	return st.st_uid == geteuid() && !(st.st_mode & (S_IWGRP | S_IWOTH));
+}
+
+// Finds the cache directory, or sets problem to why it cannot be used.
+static const string LocateCacheDirectory(string &problem) {
+	string base;
+
+	if (const char *xdg = getenv("XDG_CACHE_HOME"); xdg && xdg[0] == '/') {
+		base = xdg;
+	} else {
+		const char *home = getenv("HOME");
+		const struct passwd *pw = getpwuid(geteuid());
+
+		if ((!home || !home[0]) && pw) {
+			home = pw->pw_dir;
+		}
+		if (!home || !home[0]) {
+			problem = "The cache directory cannot be found, as neither $XDG_CACHE_HOME nor $HOME is set.\n";
+			return "";
+		}
+
+		base = string(home) + "/.cache";
+	}
+
+	const string path = base + "/bitflipsim";
+
+	// The directories are only created if they do not exist yet, so an
+	// existing directory keeps its owner and permissions.
+	if ((mkdir(base.c_str(), 0700) < 0 && errno != EEXIST) ||
+		(mkdir(path.c_str(), 0700) < 0 && errno != EEXIST))
+	{
+		problem = "Cache directory \"" + path + "\" cannot be created.\n";
+		return "";
+	}
+
+	if (!IsPrivate(path, true)) {
+		problem = "Cache directory \"" + path + "\" is not owned by the current user, or others can write to it.\n";
+		return "";
+	}
+
+	return path;
+}
+
+// The path of the cache directory, or why it cannot be used, which is only
+// looked up once.
+static const pair<string, string> &LookUpCacheDirectory() {
+	static string problem;
+	static const pair<string, string> result = {LocateCacheDirectory(problem), problem};
+	return result;
+}
+
+// The directory where compiled netlists and transition tables are kept:
+// bitflipsim in $XDG_CACHE_HOME, or in ~/.cache. Code in it is loaded into
+// the simulator, so it is only used if no one else can write to it.
+const string GetCacheDirectory() {
+	const auto &[path, problem] = LookUpCacheDirectory();
+
+	if (path.empty()) {
+		Error(problem);
+	}
+	return path;
+}
+
+// Same as GetCacheDirectory(), for caches that can do without it: if the
+// directory cannot be used, nullopt is returned and problem tells why.
+const optional<string> FindCacheDirectory(string &problem) {
+	const auto &[path, why] = LookUpCacheDirectory();
+
+	if (path.empty()) {
+		problem = why;
+		return nullopt;
+	}
+	return path;
+}
+
+// True if a file in the cache directory was written by the current user,
+// and cannot have been changed by anyone else since.
+const bool IsPrivateFile(const string &path) {
+	return IsPrivate(path, false);
+}
+
+// Reads the words of a file in the cache directory, if the description in
+// the file matches. Otherwise the file belongs to something else with the
+// same hash. A file that anyone else could have written, or that does not
+// hold exactly num_words words, is not used either.
+const bool ReadCacheFile(const string &path, const string &description, size_t num_words, vector<uint64_t> &words) {
+	if (!IsPrivateFile(path)) {
+		return false;
+	}
+
+	ifstream file(path, ios::binary);
+	uint64_t description_size = 0;
+	uint64_t stored_words = 0;
+
+	if (!file.read((char *)&description_size, sizeof(description_size)) ||
+		description_size != description.size())
+	{
+		return false;
+	}
+
+	string stored(description_size, '\0');
+	if (!file.read(stored.data(), description_size) ||
+		stored != description ||
+		!file.read((char *)&stored_words, sizeof(stored_words)) ||
+		stored_words != num_words)
+	{
+		return false;
+	}
+
+	words.resize(num_words);
+	return file.read((char *)words.data(), num_words * sizeof(uint64_t)) && file.peek() == EOF;
+}
+
+// Writes the words with their description to a file in the cache
+// directory. The file is written under a temporary name first, so that
+// other processes never read a partial file.
+void WriteCacheFile(const string &path, const string &description, const vector<uint64_t> &words) {
+	const string temp_path = path + '.' + to_string(getpid());
+	const uint64_t description_size = description.size();
+	const uint64_t num_words = words.size();
+
+	ofstream file(temp_path, ios::binary);
+	file.write((const char *)&description_size, sizeof(description_size));
+	file.write(description.data(), description_size);
+	file.write((const char *)&num_words, sizeof(num_words));
+	file.write((const char *)words.data(), num_words * sizeof(uint64_t));
+	file.close();
+
+	std::error_code ec;
+	if (file) {
+		std::filesystem::permissions(temp_path, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write, ec);
+		std::filesystem::rename(temp_path, path, ec);
+	} else {
+		std::filesystem::remove(temp_path, ec);
+	}
+}
+
 map<string, PORTS> PortNameToPortMap = {{"A",              PORTS::A},
 										{"B",              PORTS::B},
 										{"C",              PORTS::C},
@@ -2,6 +2,12 @@
 #define UTILS_H
 
 void Error(const string &err) __attribute__ ((noreturn));
+const uint64_t Hash(const string &text);
+const string GetCacheDirectory();
+const optional<string> FindCacheDirectory(string &problem);
+const bool IsPrivateFile(const string &path);
+const bool ReadCacheFile(const string &path, const string &description, size_t num_words, vector<uint64_t> &words);
+void WriteCacheFile(const string &path, const string &description, const vector<uint64_t> &words);
 
 enum class PORTS {A, B, C, Cin, Cout, I, O, S, X_2I, X_2I_MINUS_ONE, X_2I_PLUS_ONE, Y_LSB, Y_MSB, NEG, SE, ROW_LSB, X1_b, X2_b, Z, Yj, Yj_m1, PPTj, NEG_CIN};
 enum class PORT_DIR {INPUT, OUTPUT};
@@ -9,6 +15,8 @@ enum class NUMFMT {NONE, TWOS_COMPLEMENT, ONES_COMPLEMENT, SIGNED_MAGNITUDE, UNS
 enum class LAYOUT {NONE, CARRY_PROPAGATE, CARRY_SAVE, BOOTH_RADIX_2, BOOTH_RADIX_4};
 enum class TYPE {NONE, INVERSION, SIGN_EXTEND, BAUGH_WOOLEY};
 enum class DIRECTION {UP, DOWN};
+enum class ENGINE {SWEEP, LEVELIZED, EVENT, PARALLEL, COMPILED, TIMED, TIMED_PARALLEL};
+enum class SPLIT {TIME, LEVELS};
 
 extern map<string, PORTS> PortNameToPortMap;
 extern map<PORTS, string> PortToPortNameMap;
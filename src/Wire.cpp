@@ -3,6 +3,8 @@
 bool Wire::declarationGenerated = false;
 
 void Wire::SetValue(bool val, bool propagating) {
+	const bool value_changed = curr_value ^ val;
+
 	if (propagating) {
 		has_changed = curr_value ^ val;
 	} else {
@@ -15,30 +17,161 @@ void Wire::SetValue(bool val, bool propagating) {
 	if (has_changed) {
 		if (!propagating) {
 			toggle_count += num_outputs;
+
+			if (toggle_counter) {
+				*toggle_counter += num_outputs;
+			}
+		}
+
+		if (arena) {
+			for (uint32_t i = comp_fanout_begin; i < comp_fanout_end; ++i) {
+				arena->GetFanoutComponent(i)->MarkUpdate();
+			}
+
+			for (uint32_t i = wire_fanout_begin; i < wire_fanout_end; ++i) {
+				arena->GetFanoutWire(i)->SetValue(val, true);
+			}
+
+			return;
 		}
 
-		for (const auto &c : comp_outputs) {
+		for (const auto &c : connections->comp_outputs) {
 			if (const auto &spt = c.lock()) {
 				spt->MarkUpdate();
 			}
 		}
 
-		for (const auto &w : wire_outputs) {
+		for (const auto &w : connections->wire_outputs) {
 			if (const auto &spt = w.lock()) {
 				spt->SetValue(val, true);
 			}
 		}
+	} else if (value_changed) {
+		// Committing the value that the wire had before propagation does not
+		// mark the components, but the composite components that contain
+		// them still have to update them once more.
+		if (arena) {
+			for (uint32_t i = comp_fanout_begin; i < comp_fanout_end; ++i) {
+				arena->GetFanoutComponent(i)->MarkDirty();
+			}
+
+			return;
+		}
+
+		for (const auto &c : connections->comp_outputs) {
+			if (const auto &spt = c.lock()) {
+				spt->MarkDirty();
+			}
+		}
+	}
+}
+
+// Commits a value that was computed outside of the components, like by a
+// Netlist. The toggle is counted for this wire only, and the components
+// driven by this wire are not marked for an update.
+void Wire::SyncValue(bool val) {
+	has_changed = prev_value ^ val;
+	prev_value = val;
+	curr_value = val;
+
+	if (has_changed) {
+		toggle_count += num_outputs;
+
+		if (toggle_counter) {
+			*toggle_counter += num_outputs;
+		}
+	}
+}
+
+// Sets the value and the toggles the wire had when a snapshot was taken.
+// The running total is restored by the system as a whole.
+void Wire::Restore(bool val, size_t toggles) {
+	curr_value = val;
+	prev_value = val;
+	has_changed = false;
+	toggle_count = toggles;
+}
+
+// Makes this wire add its toggles to counter, including the ones it has
+// counted so far. Pass nullptr to stop, which takes them out again.
+void Wire::SetToggleCounter(size_t *counter) {
+	if (toggle_counter) {
+		*toggle_counter -= toggle_count;
+	}
+
+	toggle_counter = counter;
+
+	if (toggle_counter) {
+		*toggle_counter += toggle_count;
+	}
+}
+
+// Lets the arena that took over the connections of this wire hold them
+// from now on.
+void Wire::SetArena(const Arena *_arena, uint32_t _handle, uint32_t comp_begin, uint32_t comp_end, uint32_t wire_begin, uint32_t wire_end) {
+	arena = _arena;
+	handle = _handle;
+	comp_fanout_begin = comp_begin;
+	comp_fanout_end = comp_end;
+	wire_fanout_begin = wire_begin;
+	wire_fanout_end = wire_end;
+	connections.reset();
+}
+
+Component *Wire::GetComponentInput() const {
+	return arena ? arena->GetComponentInput(handle) : connections->comp_input.lock().get();
+}
+
+Wire *Wire::GetWireInput() const {
+	return arena ? arena->GetWireInput(handle) : connections->wire_input.lock().get();
+}
+
+const vector<Component *> Wire::GetComponentOutputs() const {
+	vector<Component *> outputs;
+
+	if (arena) {
+		for (uint32_t i = comp_fanout_begin; i < comp_fanout_end; ++i) {
+			outputs.push_back(arena->GetFanoutComponent(i));
+		}
+	} else {
+		for (const auto &c : connections->comp_outputs) {
+			if (const auto &spt = c.lock()) {
+				outputs.push_back(spt.get());
+			}
+		}
 	}
+
+	return outputs;
+}
+
+const vector<Wire *> Wire::GetWireOutputs() const {
+	vector<Wire *> outputs;
+
+	if (arena) {
+		for (uint32_t i = wire_fanout_begin; i < wire_fanout_end; ++i) {
+			outputs.push_back(arena->GetFanoutWire(i));
+		}
+	} else {
+		for (const auto &w : connections->wire_outputs) {
+			if (const auto &spt = w.lock()) {
+				outputs.push_back(spt.get());
+			}
+		}
+	}
+
+	return outputs;
 }
 
 void Wire::SetInput(const comp_t &component) {
-	comp_input = component;
-	wire_input.reset();
+	CheckConnections();
+	connections->comp_input = component;
+	connections->wire_input.reset();
 }
 
 void Wire::SetInput(const wire_t &wire) {
-	wire_input = wire;
-	comp_input.reset();
+	CheckConnections();
+	connections->wire_input = wire;
+	connections->comp_input.reset();
 }
 
 void Wire::AddOutput(const comp_t &component) {
@@ -48,15 +181,23 @@ void Wire::AddOutput(const comp_t &component) {
 //	{
 
 	// TODO: Check if the component was already added.
-	comp_outputs.emplace_back(component);
-	num_outputs = wire_outputs.size() + comp_outputs.size();
+	CheckConnections();
+	connections->comp_outputs.emplace_back(component);
+	num_outputs = connections->wire_outputs.size() + connections->comp_outputs.size();
 //	}
 }
 
 void Wire::AddOutput(const wire_t &wire) {
 	// TODO: Check if the wire was already added.
-	wire_outputs.emplace_back(wire);
-	num_outputs = wire_outputs.size() + comp_outputs.size();
+	CheckConnections();
+	connections->wire_outputs.emplace_back(wire);
+	num_outputs = connections->wire_outputs.size() + connections->comp_outputs.size();
+}
+
+void Wire::CheckConnections() const {
+	if (!connections) {
+		Error("Wire \"" + name + "\" cannot be connected once the arena of the system is built.\n");
+	}
 }
 
 void Wire::GenerateVHDLDeclaration() const {
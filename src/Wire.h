@@ -11,6 +11,10 @@ public:
 	~Wire() = default;
 
 	void SetValue(bool val, bool propagating = true);
+	void SyncValue(bool val);
+	void Restore(bool val, size_t toggles);
+	void SetToggleCounter(size_t *counter);
+	void SetArena(const Arena *_arena, uint32_t _handle, uint32_t comp_begin, uint32_t comp_end, uint32_t wire_begin, uint32_t wire_end);
 	void SetInput(const comp_t &component);
 	void SetInput(const wire_t &wire);
 	void AddOutput(const comp_t &component);
@@ -22,10 +26,10 @@ public:
 	const bool HasChanged() const {return has_changed;}
 	const string &GetName() const {return name;}
 	const size_t GetNumToggles() const {return toggle_count;}
-	const comp_wt &GetComponentInput() const {return comp_input;}
-	const wire_wt &GetWireInput() const {return wire_input;}
-	const vector<comp_wt> &GetComponentOutputs() const {return comp_outputs;}
-	const vector<wire_wt> &GetWireOutputs() const {return wire_outputs;}
+	Component *GetComponentInput() const;
+	Wire *GetWireInput() const;
+	const vector<Component *> GetComponentOutputs() const;
+	const vector<Wire *> GetWireOutputs() const;
 	const wb_t GetWireBundle() const {return part_of_bundle;}
 	const size_t GetNumOutputs() const {return num_outputs;};
 	const bool IsInputWire() const {return is_input_wire;}
@@ -37,6 +41,8 @@ public:
 	void GenerateVHDLIOAssignment() const;
 
 private:
+	void CheckConnections() const;
+
 	bool curr_value = false; // The current value on the wire.
 	bool prev_value = false; // The value on the wire before propagation started.
 	bool has_changed = false; // True if the value that is set is different from the current value.
@@ -44,13 +50,28 @@ private:
 	bool is_output_wire = false; // True if this wire is connected to the global output.
 
 	size_t toggle_count = 0; // Tracks how many times this wire has changed its value.
+	size_t *toggle_counter = nullptr; // Running total that the toggles of this wire are added to as well.
 	string name; // Name of this wire.
 
-	comp_wt comp_input; // The component that drives this wire.
-	wire_wt wire_input; // The wire that drives this wire.
-	vector<comp_wt> comp_outputs; // The components that are driven by this wire.
-	vector<wire_wt> wire_outputs; // The wires that are driven by this wire.
+	// What this wire is connected to while the system is being built. The
+	// Arena takes them over once it is built, and they are freed.
+	struct Connections {
+		comp_wt comp_input; // The component that drives this wire.
+		wire_wt wire_input; // The wire that drives this wire.
+		vector<comp_wt> comp_outputs; // The components that are driven by this wire.
+		vector<wire_wt> wire_outputs; // The wires that are driven by this wire.
+	};
+	unique_ptr<Connections> connections = make_unique<Connections>();
 	size_t num_outputs = 1; // The number of components and wires that are driven by this wire.
+
+	// The arena that holds the connections of this wire once it is built,
+	// the handle of this wire in it, and the spans of its fanout there.
+	const Arena *arena = nullptr;
+	uint32_t handle = 0;
+	uint32_t comp_fanout_begin = 0;
+	uint32_t comp_fanout_end = 0;
+	uint32_t wire_fanout_begin = 0;
+	uint32_t wire_fanout_end = 0;
 	wb_t part_of_bundle = nullptr; // Indicates whether this wire is part of a bundle.
 
 	static bool declarationGenerated; // Used for generating HDL.
@@ -23,19 +23,25 @@ const int64_t WireBundle::GetValue() const {
 }
 
 const int64_t WireBundle::Get2CValue() const {
-	int64_t result = GetValue();
+	return To2CValue(GetValue());
+}
+
+// Converts the bits of a value in the representation of this bundle to
+// two's complement.
+const int64_t WireBundle::To2CValue(int64_t result) const {
+	const bool msb = (result >> (size - 1)) & 1;
 
 	switch(repr) {
 	case REPR::TWOS_COMPLEMENT: {
 		// Modify the result if the MSB is a 1.
-		if (wires.back()->GetValue()) {
+		if (msb) {
 			result = (-1 & ~((1l << (size - 1)) - 1)) | result;
 		}
 		break;
 	}
 	case REPR::ONES_COMPLEMENT: {
 		// Modify the result if the MSB is a 1.
-		if (wires.back()->GetValue()) {
+		if (msb) {
 			result = (-1 & ~((1l << (size - 1)) - 1)) | result;
 			result += 1;
 		}
@@ -43,7 +49,7 @@ const int64_t WireBundle::Get2CValue() const {
 	}
 	case REPR::SIGNED_MAGNITUDE: {
 		// Modify the result if the MSB is a 1.
-		if (wires.back()->GetValue()) {
+		if (msb) {
 			result &= ((1l << (size - 1)) - 1);
 			result = -result;
 		}
@@ -74,6 +80,20 @@ void WireBundle::Init() {
 }
 
 void WireBundle::SetValue(int64_t value, bool propagating) {
+	value = From2CValue(value);
+
+	for (int64_t i = size - 1; i >= 0; --i) {
+		bool bit_val = false;
+		if (value & (1ull << i)) {
+			bit_val = true;
+		}
+
+		wires[i]->SetValue(bit_val, propagating);
+	}
+}
+
+// Converts a value to the bits of its representation in this bundle.
+const int64_t WireBundle::From2CValue(int64_t value) const {
 	switch(repr) {
 	case REPR::TWOS_COMPLEMENT: break;
 	case REPR::ONES_COMPLEMENT: {
@@ -90,12 +110,5 @@ void WireBundle::SetValue(int64_t value, bool propagating) {
 	}
 	}
 
-	for (int64_t i = size - 1; i >= 0; --i) {
-		bool bit_val = false;
-		if (value & (1ull << i)) {
-			bit_val = true;
-		}
-
-		wires[i]->SetValue(bit_val, propagating);
-	}
+	return value;
 }
@@ -16,6 +16,8 @@ public:
 	const vector<wire_t> &GetWires() const {return wires;}
 	const int64_t GetValue() const;
 	const int64_t Get2CValue() const;
+	const int64_t To2CValue(int64_t value) const;
+	const int64_t From2CValue(int64_t value) const;
 	const REPR GetRepresentation() const {return repr;};
 	const bool IsInputBundle() const {return is_input_bundle;}
 	const bool IsOutputBundle() const {return is_output_bundle;}
@@ -1067,15 +1067,139 @@ const constr_t ParseConstraint(const YAML::Node &node) {
 	return make_shared<Constraint>(wire_name, beg_idx, end_idx, type, seed, sigma, ub, lb, times);
 }
 
-void ParseStimuli(System &system, YAML::Node config, const string &config_file_name, bool print_debug) {
-	const auto &stimuli = config["stimuli"];
+// Parses the stimulus value of a single wire.
+bool ParseWireValue(const string &wire_name, const string &value_name) {
+	if (value_name.compare("1") == 0 || value_name.compare("true") == 0) {
+		return true;
+	} else if (value_name.compare("0") == 0 || value_name.compare("false") == 0) {
+		return false;
+	}
+
+	Error("Stimulus value of wire \"" + wire_name
+		  + "\" has to be one of the following: 0, 1, true, false.\n");
+}
+
+// Parses the stimulus value of a wire bundle, which begins with either:
+// * "0b" for binary representation
+// * "0x" for hexadecimal representation
+// * "0d" for decimal representation
+int64_t ParseBundleValue(const string &value_name) {
+	auto value_string = value_name;
+	auto base = 0;
+
+	if (value_string.length() > 2) {
+		const auto &prefix = value_string.substr(0, 2);
+		if (prefix.compare("0b") == 0 || prefix.compare("0B") == 0) {
+			base = 2;
+		} else if (prefix.compare("0x") == 0 || prefix.compare("0X") == 0) {
+			base = 16;
+		} else if (prefix.compare("0d") == 0 || prefix.compare("0D") == 0) {
+			base = 10;
+		}
+	}
+
+	if (base) {
+		// Remove the prefix
+		value_string.erase(0, 2);
+
+		try {
+			return stol(value_string, 0, base);
+		} catch (invalid_argument e) {
+		} catch (out_of_range e) {
+			Error("Value \"" + value_string + "\" is too large.\n");
+		}
+	}
+
+	Error("Value \"" + value_string + "\" in stimuli section "
+		  + "is invalid. It should begin with either '0b'/'0B', '0x'/'0X', "
+		  + "or '0d'/'0D' for binary, hexadecimal, and decimal "
+		  + "representations respectively, then followed by a value.\n");
+}
 
-	auto error_invalid_value = [](const auto &val) {
-		Error("Value \"" + val + "\" in stimuli section "
-			  + "is invalid. It should begin with either '0b'/'0B', '0x'/'0X', "
-			  + "or '0d'/'0D' for binary, hexadecimal, and decimal "
-			  + "representations respectively, then followed by a value.\n");
+// Simulates every tail of a stimulus in a fork of the system, each in a
+// thread of its own, and prints the toggles that the tail caused. A tail is a
+// sequence of stimuli that only sets wires and wire bundles, and the system
+// itself continues as if the tails were not there.
+void SimulateTails(System &system, const YAML::Node &tails, size_t stimulus) {
+	struct tail_value {
+		wire_t wire;
+		wb_t wb;
+		int64_t value;
 	};
+	vector<string> names;
+	vector<vector<vector<tail_value>>> steps;
+
+	if (!tails.IsMap()) {
+		Error("The \"tails\" of stimulus " + to_string(stimulus) + " need to be a map from the name of each tail to its sequence of stimuli.\n");
+	}
+
+	// All values are parsed before the threads start, so that an invalid
+	// one is reported right away.
+	for (const auto &tail : tails) {
+		const auto &name = tail.first.as<string>();
+
+		if (!tail.second.IsSequence()) {
+			Error("Tail \"" + name + "\" of stimulus " + to_string(stimulus) + " needs to be a sequence of stimuli.\n");
+		}
+
+		names.push_back(name);
+		steps.emplace_back();
+
+		for (const auto &step : tail.second) {
+			auto &values = steps.back().emplace_back();
+
+			for (const auto &entry : step) {
+				const auto &key_name = entry.first.as<string>();
+				const auto &value_name = entry.second.as<string>();
+				const auto &wire = system.GetWire(key_name);
+				const auto &wb = system.GetWireBundle(key_name);
+
+				if (wire) {
+					values.push_back({wire, nullptr, ParseWireValue(key_name, value_name)});
+				} else if (wb) {
+					values.push_back({nullptr, wb, ParseBundleValue(value_name)});
+				} else {
+					Error("Non-existent wire or wire bundle \"" + key_name + "\" found in tail \"" + name + "\".\n");
+				}
+			}
+		}
+	}
+
+	vector<shared_ptr<SystemFork>> forks;
+	vector<thread> threads;
+
+	for (size_t t = 0; t < names.size(); ++t) {
+		forks.push_back(system.Fork());
+	}
+
+	// Forking flushed the stimuli that the engine was still holding back.
+	const size_t prev_toggles = system.GetNumToggles();
+
+	for (size_t t = 0; t < names.size(); ++t) {
+		threads.emplace_back([&, t]() {
+			for (const auto &values : steps[t]) {
+				for (const auto &v : values) {
+					if (v.wire) {
+						forks[t]->SetValue(v.wire, (bool)v.value);
+					} else {
+						forks[t]->SetValue(v.wb, v.value);
+					}
+				}
+
+				forks[t]->Update();
+			}
+		});
+	}
+
+	for (size_t t = 0; t < names.size(); ++t) {
+		threads[t].join();
+		cout << "Toggles of tail \"" << names[t] << "\" after stimulus " << stimulus << ": "
+			 << forks[t]->GetNumToggles() - prev_toggles << '\n';
+	}
+}
+
+void ParseStimuli(System &system, YAML::Node config, const string &config_file_name, bool print_debug) {
+	const auto &stimuli = config["stimuli"];
 
 	auto error_constraint_map = []() {
 		Error(string("A \"constraint\" needs to be either a map, or a sequence ")
@@ -1127,7 +1251,11 @@ void ParseStimuli(System &system, YAML::Node config, const string &config_file_n
 	}
 
 	vector<size_t> toggles = {};
+	vector<size_t> events = {}; // Only filled by the event-driven and timed engines.
+	vector<size_t> glitches = {}; // Only filled by the timed engines.
 	vector<float> sigmas = {};
+	const bool count_events = system.GetEngine() == ENGINE::EVENT || system.GetEngine() == ENGINE::TIMED;
+	const bool count_glitches = system.GetEngine() == ENGINE::TIMED || system.GetEngine() == ENGINE::TIMED_PARALLEL;
 
 	auto process_wire_rng = [&](const auto &wire, const auto &constraint, auto &system, const size_t num_times) {
 		for (size_t i = 0; i < num_times; ++i) {
@@ -1214,13 +1342,110 @@ void ParseStimuli(System &system, YAML::Node config, const string &config_file_n
 	};
 
 	size_t prev_toggles = 0;
+	size_t prev_series_toggles = 0;
+	size_t prev_events = 0;
+	size_t prev_glitches = 0;
+
+	// What to record once an update has been simulated. The pattern-parallel
+	// engine simulates updates in batches, so the results of an update may
+	// only become available after later stimuli have been applied.
+	// A restored snapshot is recorded before the first update after it, so
+	// that the toggles of that update are counted from the snapshot.
+	enum class RECORD {NOTHING, OUTPUTS, SERIES, RESTORE};
+	deque<RECORD> pending_records;
+	deque<size_t> restored_toggles; // The toggles of the snapshot of each RESTORE record.
+	map<string, shared_ptr<const Snapshot>> snapshots;
+
+	system.SetCommitHandler([&]() {
+		while (pending_records.front() == RECORD::RESTORE) {
+			prev_toggles = restored_toggles.front();
+			prev_series_toggles = prev_toggles;
+			restored_toggles.pop_front();
+			pending_records.pop_front();
+		}
+
+		const auto record = pending_records.front();
+		pending_records.pop_front();
+
+		if (record == RECORD::NOTHING) {
+			return;
+		}
+
+		for (const auto &o : system.GetOutputWireBundles()) {
+			out_values[o->GetName()]->values.emplace_back(o->GetValue());
+			out_values[o->GetName()]->values_2C.emplace_back(o->Get2CValue());
+		}
+
+		const size_t curr_toggles = system.GetNumToggles();
+
+		if (record == RECORD::SERIES) {
+			toggles.emplace_back(curr_toggles - prev_series_toggles);
+			prev_series_toggles = curr_toggles;
+
+			if (count_events) {
+				const size_t curr_events = system.GetNumEvents();
+				events.emplace_back(curr_events - prev_events);
+				prev_events = curr_events;
+			}
+
+			if (count_glitches) {
+				const size_t curr_glitches = system.GetNumGlitchToggles();
+				glitches.emplace_back(curr_glitches - prev_glitches);
+				prev_glitches = curr_glitches;
+			}
+		} else {
+			if (print_debug) {
+				cout << "#toggles: " << (curr_toggles - prev_toggles) << "\n";
+			}
+			prev_toggles = curr_toggles;
+		}
+	});
+
+	auto update = [&](const RECORD record) {
+		pending_records.push_back(record);
+		system.Update();
+	};
 
 	vector<constr_t> constraints;
+	bool warned_hold = false;
 
 	for (size_t i = 0; i < stimuli.size(); ++i) {
 		if (print_debug) {
 			cout << "\nStimulus " << i << '\n';
 		}
+		string snapshot_name;
+		optional<YAML::Node> tails;
+
+		// The records of a stimulus file are simulated as stimuli of their
+		// own, so such a stimulus has no values to simulate after them.
+		const bool from_file = stimuli[i].IsMap() && stimuli[i]["file"];
+
+		if (from_file) {
+			for (const auto &step : stimuli[i]) {
+				const auto &key_name = step.first.as<string>();
+
+				if (key_name.compare("file") != 0 && key_name.compare("snapshot") != 0) {
+					Error("Stimulus " + to_string(i) + " has a \"file\" entry, which can only be combined with a \"snapshot\" entry, not with \"" + key_name + "\".\n");
+				}
+			}
+		}
+
+		// The stimulus continues from the state of a snapshot that was taken
+		// before. It is restored before any values are applied, wherever it
+		// is listed in the stimulus, so that it does not overwrite them.
+		if (stimuli[i].IsMap() && stimuli[i]["restore"]) {
+			const auto &name = stimuli[i]["restore"].as<string>();
+			const auto it = snapshots.find(name);
+
+			if (it == snapshots.end()) {
+				Error("Snapshot \"" + name + "\" is restored before it is taken.\n");
+			}
+
+			system.Restore(it->second);
+			pending_records.push_back(RECORD::RESTORE);
+			restored_toggles.push_back(it->second->GetNumToggles());
+		}
+
 		for (const auto &step : stimuli[i]) {
 			const auto &key_name = step.first.as<string>();
 			const auto &value_node = step.second;
@@ -1242,7 +1467,11 @@ void ParseStimuli(System &system, YAML::Node config, const string &config_file_n
 						sigmas.emplace_back(c->sigma);
 					}
 
-					size_t prev = system.GetNumToggles();
+					// The toggles of the series are counted from here on.
+					system.Flush();
+					prev_series_toggles = system.GetNumToggles();
+					prev_events = system.GetNumEvents();
+					prev_glitches = system.GetNumGlitchToggles();
 					for (size_t i = 0; i < max_repetitions; ++i) {
 						for (const auto &c : constraints) {
 							if (c->times) {
@@ -1293,15 +1522,7 @@ void ParseStimuli(System &system, YAML::Node config, const string &config_file_n
 							}
 						}
 
-						system.Update();
-						for (const auto &o : system.GetOutputWireBundles()) {
-							out_values[o->GetName()]->values.emplace_back(o->GetValue());
-							out_values[o->GetName()]->values_2C.emplace_back(o->Get2CValue());
-						}
-
-						const size_t curr_toggles = system.GetNumToggles();
-						toggles.emplace_back(curr_toggles - prev);
-						prev = curr_toggles;
+						update(RECORD::SERIES);
 					}
 				} else if (value_node.IsMap()) {
 					// The constraint applies to one wire or wire bundle.
@@ -1314,7 +1535,7 @@ void ParseStimuli(System &system, YAML::Node config, const string &config_file_n
 						case Constraint::TYPE::RNG:
 						case Constraint::TYPE::UNIFORM: {
 							process_wire_rng(w, c, system, c->times);
-							system.Update();
+							update(RECORD::NOTHING);
 							break;
 						}
 						case Constraint::TYPE::NONE: break;
@@ -1324,7 +1545,7 @@ void ParseStimuli(System &system, YAML::Node config, const string &config_file_n
 						switch (c->type) {
 						case Constraint::TYPE::RNG: {
 							process_wire_bundle_rng(wb, c, system, c->times);
-							system.Update();
+							update(RECORD::NOTHING);
 							break;
 						}
 						case Constraint::TYPE::UNIFORM: {
@@ -1358,6 +1579,76 @@ void ParseStimuli(System &system, YAML::Node config, const string &config_file_n
 				}
 
 				//continue;
+			} else if (key_name.compare("hold") == 0) {
+				// The wires and wire bundles keep their values for a while,
+				// so the netlist can be specialized for them. An empty
+				// sequence releases them.
+				vector<wire_t> held_wires;
+				vector<string> names;
+
+				if (value_node.IsSequence()) {
+					names = value_node.as<vector<string>>();
+				} else if (value_node.IsScalar()) {
+					names.push_back(value_node.as<string>());
+				}
+
+				for (const auto &name : names) {
+					const auto &w = system.GetWire(name);
+					const auto &wb = system.GetWireBundle(name);
+
+					if (w) {
+						held_wires.push_back(w);
+					} else if (wb) {
+						held_wires.insert(held_wires.end(), wb->GetWires().begin(), wb->GetWires().end());
+					} else {
+						error_non_existent_wire(name);
+					}
+				}
+
+				if (!warned_hold && (system.GetEngine() == ENGINE::SWEEP || system.GetEngine() == ENGINE::COMPILED)) {
+					cout << "[Warning] The \"sweep\" and \"compiled\" engines do not specialize the netlist, so held wires are simulated as usual.\n";
+					warned_hold = true;
+				}
+
+				system.HoldWires(held_wires);
+			} else if (key_name.compare("file") == 0) {
+				// Every record of a binary stimulus file is simulated like a
+				// stimulus of its own. A relative path starts at the
+				// directory of the configuration file.
+				std::filesystem::path path = value_node.as<string>();
+
+				if (path.is_relative()) {
+					path = std::filesystem::path(config_file_name).parent_path() / path;
+				}
+
+				const StimulusFile file(path.string(), system);
+				const auto &fields = file.GetFields();
+
+				system.UpdateFromFile(file, [&](size_t record) {
+					for (size_t f = 0; f < fields.size(); ++f) {
+						const auto &io_val = in_values[fields[f].name];
+
+						io_val->values.emplace_back((int64_t)file.GetValue(record, f));
+						if (fields[f].bundle) {
+							io_val->values_2C.emplace_back(file.Get2CValue(record, f));
+						}
+					}
+
+					pending_records.push_back(RECORD::OUTPUTS);
+				});
+
+				if (print_debug) {
+					cout << "Records of " << path.string() << ": " << file.GetNumRecords() << '\n';
+				}
+			} else if (key_name.compare("snapshot") == 0) {
+				// The state after this stimulus is kept under the given name.
+				snapshot_name = value_node.as<string>();
+			} else if (key_name.compare("tails") == 0) {
+				// The tails continue from the state after this stimulus,
+				// each in a fork of the system.
+				tails = value_node;
+			} else if (key_name.compare("restore") == 0) {
+				// Already restored before the values were applied.
 			} else {
 				// The key is a wire or wire bundle.
 				const auto &value_name = value_node.as<string>();
@@ -1365,16 +1656,7 @@ void ParseStimuli(System &system, YAML::Node config, const string &config_file_n
 				const auto &wb = system.GetWireBundle(key_name);
 
 				if (wire) {
-					auto value = false;
-
-					if (value_name.compare("1") == 0 || value_name.compare("true") == 0) {
-						value = true;
-					} else if (value_name.compare("0") == 0 || value_name.compare("false") == 0) {
-						value = false;
-					} else {
-						Error("Stimulus value of wire \"" + key_name
-							 +	"\" has to be one of the following: 0, 1, true, false.\n");
-					}
+					const auto value = ParseWireValue(key_name, value_name);
 					wire->SetValue(value, false);
 
 					const auto &io_val = in_values[wire->GetName()];
@@ -1391,53 +1673,22 @@ void ParseStimuli(System &system, YAML::Node config, const string &config_file_n
 						cout << key_name << ": " << value << '\n';
 					}
 				} else if (wb) {
-					auto value_string = value_name;
-					auto base = 2;
-
-					// A wire bundle value begins with either:
-					// * "0b" for binary representation
-					// * "0x" for hexadecimal representation
-					// * "0d" for decimal representation
-					if (value_string.length() > 2) {
-						const auto &prefix = value_string.substr(0, 2);
-						if (prefix.compare("0b") == 0 || prefix.compare("0B") == 0) {
-							base = 2;
-						} else if (prefix.compare("0x") == 0 || prefix.compare("0X") == 0) {
-							base = 16;
-						} else if (prefix.compare("0d") == 0 || prefix.compare("0D") == 0) {
-							base = 10;
-						} else {
-							error_invalid_value(value_string);
-						}
-					} else {
-						error_invalid_value(value_string);
-					}
-
-					// Remove the prefix
-					value_string.erase(0, 2);
+					const int64_t value = ParseBundleValue(value_name);
+					wb->SetValue(value, false);
 
-					try {
-						const int64_t value = stol(value_string, 0, base);
-						wb->SetValue(value, false);
-
-						const auto &io_val = in_values[wb->GetName()];
-						io_val->values.emplace_back((int64_t)value);
-						io_val->values_2C.emplace_back(wb->Get2CValue());
-						if (io_val->wb == nullptr) {
-							io_val->wb = wb;
-						}
+					const auto &io_val = in_values[wb->GetName()];
+					io_val->values.emplace_back((int64_t)value);
+					io_val->values_2C.emplace_back(wb->Get2CValue());
+					if (io_val->wb == nullptr) {
+						io_val->wb = wb;
+					}
 
-						if (print_debug) {
-							// Print the bundle name and value in hex and binary.
-							cout << wb->GetName() << ": "
-								 << wb->Get2CValue() << " "
-								 << ValueToHexString(wb->GetValue()) << " "
-								 << ValueToBinaryString(wb->GetValue(), wb->GetSize()) << '\n';
-						}
-					} catch (invalid_argument e) {
-						error_invalid_value(value_string);
-					} catch (out_of_range e) {
-						Error("Value \"" + value_string + "\" is too large.\n");
+					if (print_debug) {
+						// Print the bundle name and value in hex and binary.
+						cout << wb->GetName() << ": "
+							 << wb->Get2CValue() << " "
+							 << ValueToHexString(wb->GetValue()) << " "
+							 << ValueToBinaryString(wb->GetValue(), wb->GetSize()) << '\n';
 					}
 				} else {
 					Error(string("Non-existent wire or wire bundle \"") + key_name + "\" found in stimuli section.\n");
@@ -1445,19 +1696,22 @@ void ParseStimuli(System &system, YAML::Node config, const string &config_file_n
 			}
 		}
 
-		system.Update();
-		for (const auto &o : system.GetOutputWireBundles()) {
-			out_values[o->GetName()]->values.emplace_back(o->GetValue());
-			out_values[o->GetName()]->values_2C.emplace_back(o->Get2CValue());
+		if (!from_file) {
+			update(RECORD::OUTPUTS);
 		}
 
-		const size_t curr_toggles = system.GetNumToggles();
-		if (print_debug) {
-			cout << "#toggles: " << (curr_toggles - prev_toggles) << "\n";
+		if (!snapshot_name.empty()) {
+			snapshots[snapshot_name] = system.TakeSnapshot();
+		}
+
+		if (tails) {
+			SimulateTails(system, tails.value(), i);
 		}
-		prev_toggles = curr_toggles;
 	}
 
+	system.Flush();
+	system.SetCommitHandler(nullptr);
+
 	// Output file that has the values given to the inputs,
 	// is produced on the outputs, and how many toggles each input caused.
 	auto outfile_name = config_file_name.substr(0, config_file_name.find_last_of("."));
@@ -1498,6 +1752,22 @@ void ParseStimuli(System &system, YAML::Node config, const string &config_file_n
 	for (const auto &val : toggles) {
 		outfile << val << ',';
 	}
+
+	if (count_events) {
+		// Number of gates evaluated per stimulus.
+		outfile << "\nevents\n";
+		for (const auto &val : events) {
+			outfile << val << ',';
+		}
+	}
+
+	if (count_glitches) {
+		// Toggles per stimulus that did not change the settled value of a wire.
+		outfile << "\nglitches\n";
+		for (const auto &val : glitches) {
+			outfile << val << ',';
+		}
+	}
 	outfile.close();
 
 	// Write a stimulus file for the testbench.
@@ -1564,6 +1834,153 @@ void ParseStimuli(System &system, YAML::Node config, const string &config_file_n
 	expected_output.close();
 }
 
+// Simulates the records of a stimulus stream instead of the stimuli section,
+// and writes the results of every record to results as soon as its batch
+// has been simulated. Only one batch is kept at a time, which holds enough
+// records to fill all batches of the pattern-parallel engines.
+void StreamStimuli(System &system, const string &stream_path, ostream &results) {
+	constexpr size_t MIN_RECORDS_PER_BATCH = 4096;
+	ifstream file;
+	istream *input = &cin;
+
+	if (stream_path.compare("-") != 0) {
+		file.open(stream_path, ios::binary);
+		if (!file) {
+			Error("Stimulus stream \"" + stream_path + "\" cannot be opened.\n");
+		}
+		input = &file;
+	}
+
+	StimulusStream stream(*input, system);
+	size_t prev_toggles = system.GetNumToggles();
+
+	// The header is written right away, so that a reader gets it even if
+	// the first batch takes a while to arrive, or never does.
+	stream.WriteHeader(results);
+	results.flush();
+	system.SetCommitHandler([&]() {
+		const size_t curr_toggles = system.GetNumToggles();
+		stream.WriteResult(results, curr_toggles - prev_toggles);
+		prev_toggles = curr_toggles;
+	});
+
+	const size_t records_per_batch = max(MIN_RECORDS_PER_BATCH, system.GetNumThreads() * PatternParallel::NUM_LANES);
+
+	while (const size_t num_records = stream.Read(records_per_batch)) {
+		for (size_t r = 0; r < num_records; ++r) {
+			stream.Apply(r);
+			system.Update();
+		}
+
+		system.Flush();
+		results.flush();
+	}
+
+	system.SetCommitHandler(nullptr);
+}
+
+ENGINE ParseEngine(const string &engine_name) {
+	if (engine_name.compare("sweep") == 0) {
+		return ENGINE::SWEEP;
+	} else if (engine_name.compare("levelized") == 0) {
+		return ENGINE::LEVELIZED;
+	} else if (engine_name.compare("event") == 0) {
+		return ENGINE::EVENT;
+	} else if (engine_name.compare("parallel") == 0) {
+		return ENGINE::PARALLEL;
+	} else if (engine_name.compare("compiled") == 0) {
+		return ENGINE::COMPILED;
+	} else if (engine_name.compare("timed") == 0) {
+		return ENGINE::TIMED;
+	} else if (engine_name.compare("timed-parallel") == 0) {
+		return ENGINE::TIMED_PARALLEL;
+	}
+
+	Error("Unknown engine \"" + engine_name + "\". Supported engines are "
+		  + "\"sweep\", \"levelized\", \"event\", \"parallel\", \"compiled\", \"timed\", and \"timed-parallel\".\n");
+}
+
+// The largest number of entries of a transition table or a response cache,
+// so that a mistyped size does not try to take all the memory.
+constexpr size_t MAX_TABLE_ENTRIES = 1 << 20;
+
+// The largest number of threads, which is a few per hardware thread.
+size_t MaxThreads() {
+	return 4 * max(1U, thread::hardware_concurrency());
+}
+
+// Parses the value of an option that is a number between 1 and max_value.
+// name describes the option in the error.
+size_t ParsePositiveNumber(const string &number, const string &name, size_t max_value) {
+	if (!number.empty() && all_of(number.begin(), number.end(), [](unsigned char c) { return isdigit(c); })) {
+		try {
+			const auto value = stoul(number);
+
+			if (value > 0 && value <= max_value) {
+				return value;
+			}
+		} catch (out_of_range e) {
+		}
+	}
+
+	Error(name + " \"" + number + "\" is invalid. It should be between 1 and " + to_string(max_value) + ".\n");
+}
+
+SPLIT ParseSplit(const string &split_name) {
+	if (split_name.compare("time") == 0) {
+		return SPLIT::TIME;
+	} else if (split_name.compare("levels") == 0) {
+		return SPLIT::LEVELS;
+	}
+
+	Error("Unknown split \"" + split_name + "\". Supported splits are \"time\" and \"levels\".\n");
+}
+
+// Parses the delays of the gate types for the timed engine, for example
+// "delays: {Xor: 2, Xnor: 2}". Gate types that are not listed have a delay
+// of 1.
+map<Netlist::GATE, size_t> ParseGateDelays(const YAML::Node &delays) {
+	const map<string, Netlist::GATE> gate_types = {
+		{"And", Netlist::GATE::AND}, {"And3", Netlist::GATE::AND3},
+		{"Or", Netlist::GATE::OR}, {"Or3", Netlist::GATE::OR3},
+		{"Xor", Netlist::GATE::XOR}, {"Nand", Netlist::GATE::NAND},
+		{"Nor", Netlist::GATE::NOR}, {"Nor3", Netlist::GATE::NOR3},
+		{"Xnor", Netlist::GATE::XNOR}, {"Not", Netlist::GATE::NOT},
+		{"Mux", Netlist::GATE::MUX}
+	};
+	map<Netlist::GATE, size_t> gate_delays;
+
+	if (!delays.IsMap()) {
+		Error("\"delays\" in the \"simulation\" section should map gate types to delays.\n");
+	}
+
+	for (const auto &delay : delays) {
+		const auto gate_name = delay.first.as<string>();
+		const auto it = gate_types.find(gate_name);
+
+		if (it == gate_types.end()) {
+			Error("Unknown gate type \"" + gate_name + "\" in \"delays\". Supported gate types are "
+				  + "And, And3, Or, Or3, Xor, Nand, Nor, Nor3, Xnor, Not, and Mux.\n");
+		}
+
+		const auto value = delay.second.as<string>();
+		try {
+			const auto d = stoul(value);
+
+			if (d > 0 && d <= 1024) {
+				gate_delays[it->second] = d;
+				continue;
+			}
+		} catch (invalid_argument e) {
+		} catch (out_of_range e) {
+		}
+
+		Error("Delay \"" + value + "\" of gate type \"" + gate_name + "\" is invalid. It should be between 1 and 1024.\n");
+	}
+
+	return gate_delays;
+}
+
 YAML::Node LoadConfigurationFile(const string &config_file_name) {
 	YAML::Node config;
 
@@ -1584,28 +2001,64 @@ int main(int argc, char **argv) {
 	System system;
 	string config_file_name;
 	bool generate_vhdl = false;
+	optional<ENGINE> engine; // Only set if given on the command line.
+	optional<size_t> num_threads; // Only set if given on the command line.
+	optional<SPLIT> split; // Only set if given on the command line.
+	bool word_level = false;
+	bool state_cache = false;
+	optional<size_t> max_table_entries; // Only set if given on the command line.
+	optional<size_t> max_cache_entries; // Only set if given on the command line.
+	vector<string> cache_types; // Types of the components that get a response cache, all if empty.
+	optional<string> stream_path; // Only set if the stimuli are streamed.
 
 	auto error_usage = []() {
-		cout << "Usage: ./bitflipsim [--vhdl] <configuration file>\n";
+		cout << "Usage: ./bitflipsim [--vhdl] [--engine <sweep|levelized|event|parallel|compiled|timed|timed-parallel>] [--threads <N>] [--split <time|levels>] [--word-level] [--state-cache] [--tables <max entries>] [--memo <max entries>] [--stream <file|->] <configuration file>\n";
 		exit(0);
 	};
 
-	// Check if a configuration file was supplied.
-	if (argc == 2) {
-		config_file_name = string(argv[1]);
-	} else if (argc == 3) {
-		string cmdline_option(argv[1]);
+	for (int i = 1; i < argc; ++i) {
+		string cmdline_option(argv[i]);
 
 		if (cmdline_option.compare("--vhdl") == 0) {
-			config_file_name = string(argv[2]);
 			generate_vhdl = true;
+		} else if (cmdline_option.compare("--engine") == 0 && (i + 1) < argc) {
+			engine = ParseEngine(argv[++i]);
+		} else if (cmdline_option.compare("--threads") == 0 && (i + 1) < argc) {
+			num_threads = ParsePositiveNumber(argv[++i], "Number of threads", MaxThreads());
+		} else if (cmdline_option.compare("--word-level") == 0) {
+			word_level = true;
+		} else if (cmdline_option.compare("--state-cache") == 0) {
+			state_cache = true;
+		} else if (cmdline_option.compare("--tables") == 0 && (i + 1) < argc) {
+			max_table_entries = ParsePositiveNumber(argv[++i], "Transition table size", MAX_TABLE_ENTRIES);
+		} else if (cmdline_option.compare("--memo") == 0 && (i + 1) < argc) {
+			max_cache_entries = ParsePositiveNumber(argv[++i], "Response cache size", MAX_TABLE_ENTRIES);
+		} else if (cmdline_option.compare("--split") == 0 && (i + 1) < argc) {
+			split = ParseSplit(argv[++i]);
+		} else if (cmdline_option.compare("--stream") == 0 && (i + 1) < argc) {
+			stream_path = argv[++i];
+		} else if (cmdline_option[0] != '-' && config_file_name.empty()) {
+			config_file_name = cmdline_option;
 		} else {
 			error_usage();
 		}
-	} else {
+	}
+
+	// Check if a configuration file was supplied.
+	if (config_file_name.empty()) {
 		error_usage();
 	}
 
+	// The results of a stream are written to stdout, so everything else is
+	// written to stderr.
+	if (stream_path) {
+		ios::sync_with_stdio(false);
+	}
+	ostream results(cout.rdbuf());
+	if (stream_path) {
+		cout.rdbuf(cerr.rdbuf());
+	}
+
 	config = LoadConfigurationFile(config_file_name);
 	string output_file_path = config_file_name.substr(0, config_file_name.find_last_of(".")) + '/';
 
@@ -1627,13 +2080,86 @@ int main(int argc, char **argv) {
 		if (wires.size() == 0) {
 			Error("\"wires\" section in \"" + config_file_name + "\" is empty.\n");
 		}
-		if (!stimuli) {
+		if (!stimuli && !stream_path) {
 			Error("No \"stimuli\" section found in \"" + config_file_name + "\"\n");
 		}
-		if (stimuli.size() == 0) {
+		if (stimuli && stimuli.size() == 0) {
 			Error("\"stimuli\" section in \"" + config_file_name + "\" is empty.\n");
 		}
 
+		// The engine given on the command line takes precedence over
+		// the one in the optional "simulation" section.
+		const auto &simulation = config["simulation"];
+		if (!engine && simulation && simulation["engine"]) {
+			engine = ParseEngine(simulation["engine"].as<string>());
+		}
+		system.SetEngine(engine.value_or(ENGINE::SWEEP));
+
+		if (!num_threads && simulation && simulation["threads"]) {
+			num_threads = ParsePositiveNumber(simulation["threads"].as<string>(), "Number of threads", MaxThreads());
+		}
+		if (num_threads.value_or(1) > 1 && system.GetEngine() != ENGINE::PARALLEL && system.GetEngine() != ENGINE::TIMED_PARALLEL) {
+			cout << "[Warning] Only the \"parallel\" and \"timed-parallel\" engines use multiple threads, so the number of threads is ignored.\n";
+		} else {
+			system.SetNumThreads(num_threads.value_or(1));
+		}
+
+		if (!split && simulation && simulation["split"]) {
+			split = ParseSplit(simulation["split"].as<string>());
+		}
+		if (split == SPLIT::LEVELS && system.GetEngine() == ENGINE::TIMED_PARALLEL) {
+			cout << "[Warning] The \"timed-parallel\" engine does not evaluate the gates level by level, so the stimuli are split over the threads instead.\n";
+			split = SPLIT::TIME;
+		}
+		system.SetSplit(split.value_or(SPLIT::TIME));
+
+		if (simulation && simulation["delays"]) {
+			if (system.GetEngine() == ENGINE::TIMED) {
+				system.SetGateDelays(ParseGateDelays(simulation["delays"]));
+			} else {
+				cout << "[Warning] Only the \"timed\" engine uses gate delays, so the delays are ignored.\n";
+			}
+		}
+
+		if (!word_level && simulation && simulation["word_level"]) {
+			word_level = simulation["word_level"].as<bool>();
+		}
+
+		if (!state_cache && simulation && simulation["state_cache"]) {
+			state_cache = simulation["state_cache"].as<bool>();
+		}
+
+		if (!max_table_entries && simulation && simulation["tables"]) {
+			max_table_entries = ParsePositiveNumber(simulation["tables"].as<string>(), "Transition table size", MAX_TABLE_ENTRIES);
+		}
+		if (max_table_entries && system.GetEngine() != ENGINE::SWEEP) {
+			cout << "[Warning] Only the \"sweep\" engine evaluates components, so no transition tables are built.\n";
+			max_table_entries.reset();
+		}
+
+		// "memo" is either the size of the caches, or a map with the size
+		// as "entries" and the component types that get one as "types".
+		if (simulation && simulation["memo"]) {
+			const auto &memo = simulation["memo"];
+
+			if (memo.IsMap()) {
+				if (!max_cache_entries && memo["entries"]) {
+					max_cache_entries = ParsePositiveNumber(memo["entries"].as<string>(), "Response cache size", MAX_TABLE_ENTRIES);
+				}
+				if (memo["types"]) {
+					for (const auto &type : memo["types"]) {
+						cache_types.push_back(type.as<string>());
+					}
+				}
+			} else if (!max_cache_entries) {
+				max_cache_entries = ParsePositiveNumber(memo.as<string>(), "Response cache size", MAX_TABLE_ENTRIES);
+			}
+		}
+		if (max_cache_entries && system.GetEngine() != ENGINE::SWEEP) {
+			cout << "[Warning] Only the \"sweep\" engine evaluates components, so no response caches are built.\n";
+			max_cache_entries.reset();
+		}
+
 		ParseComponents(comps, config);
 		vector<wi_t> wire_information = ParseWires(comps, config);
 		system.SetWireInformation(wire_information);
@@ -1650,8 +2176,20 @@ int main(int argc, char **argv) {
 			}
 		}
 
+		system.SetWordLevel(word_level);
+		if (max_table_entries) {
+			system.BuildTransitionTables(max_table_entries.value());
+		}
+		if (max_cache_entries) {
+			system.BuildResponseCaches(max_cache_entries.value(), cache_types);
+		}
+		system.BuildArena();
 		system.FindLongestPathInSystem();
-		system.FindInitialState();
+		system.Levelize();
+		system.FindInitialState(state_cache);
+		if (system.GetEngine() != ENGINE::SWEEP) {
+			system.Elaborate();
+		}
 
 		if (generate_vhdl) {
 			// Recursively create the folders of the path.
@@ -1662,10 +2200,43 @@ int main(int argc, char **argv) {
 		cout << "Number of components: " << system.GetNumComponents() <<
 			"\nNumber of wires: " << system.GetNumWires() << '\n';
 
-		ParseStimuli(system, config, config_file_name, false);
+		if (stream_path) {
+			StreamStimuli(system, stream_path.value(), results);
+		} else {
+			ParseStimuli(system, config, config_file_name, false);
+		}
 
 		cout << "\nSimulation done!\n";
 		cout << "Number of toggles: " << system.GetNumToggles() << '\n';
+		if (system.GetEngine() == ENGINE::TIMED || system.GetEngine() == ENGINE::TIMED_PARALLEL) {
+			cout << "Number of glitch toggles: " << system.GetNumGlitchToggles() << '\n';
+		}
+		if (system.GetEngine() == ENGINE::EVENT || system.GetEngine() == ENGINE::TIMED) {
+			cout << "Number of events: " << system.GetNumEvents() << '\n';
+		}
+		if (system.GetNumSpecializations()) {
+			cout << "Number of specializations: " << system.GetNumSpecializations() << '\n';
+		}
+		for (const auto &[type, caches] : system.GetResponseCaches()) {
+			size_t num_hits = 0;
+			size_t num_misses = 0;
+			size_t num_unsettled = 0;
+			size_t num_entries = 0;
+
+			for (const auto &cache : caches) {
+				num_hits += cache->GetNumHits();
+				num_misses += cache->GetNumMisses();
+				num_unsettled += cache->GetNumUnsettled();
+				num_entries += cache->GetNumEntries();
+			}
+
+			cout << "Response caches of " << type << ": " << caches.size() << " components, "
+				 << num_hits << " hits, " << num_misses << " misses";
+			if (num_hits + num_misses) {
+				cout << " (" << 100 * num_hits / (num_hits + num_misses) << "% hits)";
+			}
+			cout << ", " << num_unsettled << " not settled, " << num_entries << " entries\n";
+		}
 
 #if 0
 		cout << "\nValue of all wires:\n";
@@ -1677,10 +2248,10 @@ int main(int argc, char **argv) {
 				 << '\n';
 			cout << "Outputs:\n";
 			for (const auto &c : ow->GetComponentOutputs()) {
-				cout << '\t' << c.lock()->GetName() << '\n';
+				cout << '\t' << c->GetName() << '\n';
 			}
 			for (const auto &w : ow->GetWireOutputs()) {
-				cout << '\t' << w.lock()->GetName() << '\n';
+				cout << '\t' << w->GetName() << '\n';
 			}
 		}
 #endif
@@ -6,11 +6,21 @@
 #include <memory>
 #include <algorithm>
 #include <vector>
+#include <array>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <climits>
 #include <fstream>
 #include <bitset>
 #include <optional>
+#include <functional>
+#include <deque>
+#include <list>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <ctemplate/template.h>
 #include <tsl/ordered_map.h>
 
@@ -21,8 +31,12 @@ using namespace tsl;
 #include "Utils.h"
 
 class Component;
+class TransitionTable;
+class ResponseCache;
 class HalfAdder;
 class FullAdder;
+class AdderKernel;
+class ArrayKernel;
 class RippleCarryAdder;
 class RippleCarryAdderSubtracter;
 class RippleCarrySubtracter;
@@ -47,6 +61,15 @@ class Mux;
 class WireBundle;
 class Wire;
 class System;
+class SystemFork;
+class Arena;
+class Netlist;
+class EventQueue;
+class TimingWheel;
+class ThreadPool;
+class CompiledNetlist;
+class StimulusFile;
+class StimulusStream;
 
 using wire_t   = shared_ptr<Wire>;
 using wire_wt  = weak_ptr<Wire>;
@@ -135,9 +158,12 @@ struct WireInformation {
 
 using wi_t = shared_ptr<WireInformation>;
 
+#include "TransitionTable.h"
 #include "Component.h"
 #include "HalfAdder.h"
 #include "FullAdder.h"
+#include "AdderKernel.h"
+#include "ArrayKernel.h"
 #include "RippleCarryAdder.h"
 #include "RippleCarryAdderSubtracter.h"
 #include "RippleCarrySubtracter.h"
@@ -161,6 +187,17 @@ using wi_t = shared_ptr<WireInformation>;
 #include "Mux.h"
 #include "WireBundle.h"
 #include "Wire.h"
+#include "Arena.h"
+#include "Netlist.h"
+#include "ResponseCache.h"
+#include "EventQueue.h"
+#include "TimingWheel.h"
+#include "ThreadPool.h"
+#include "PatternParallel.h"
+#include "CompiledNetlist.h"
+#include "StimulusFile.h"
+#include "StimulusStream.h"
 #include "System.h"
+#include "SystemFork.h"
 
 #endif // MAIN_H